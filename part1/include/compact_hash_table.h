@@ -0,0 +1,327 @@
+#ifndef COMPACT_HASH_TABLE_H
+#define COMPACT_HASH_TABLE_H
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Hash Table with LRU/MRU ordering and a compact element layout. It has the same interface as HashTable<Size>
+// but every element takes 36 bytes instead of 64 bytes plus a heap allocation for keys longer than the small
+// string buffer of std::string.
+//
+// How the layout works:
+// 1. The links of the double linked list are 32-bit slot indices instead of pointers. The first and last
+// elements of the list are two extra slots at the end of the slot array, so indices Size and Size + 1.
+//
+// 2. Keys of up to 22 bytes are stored inline in the element. Longer keys are appended to a single side arena
+// and the element stores their offset and length instead. Removed long keys leave a hole in the arena, which
+// is compacted when more than half of it is holes.
+//
+// 3. Whether a slot is empty, occupied or erased is a 1 byte state instead of checking the links.
+template<uint32_t Size>
+class CompactHashTable
+{
+public:
+    using KeyType = std::string;
+    using KeyViewType = std::string_view;
+    using ValueType = uint32_t;
+    using KeyValuePair = std::tuple<KeyType, ValueType>;
+    static constexpr uint32_t ProbingFactor = 1;
+    // Longest key stored inside the element
+    static constexpr uint32_t InlineKeySize = 22;
+
+    CompactHashTable() : data(std::make_unique<std::array<HashElement, Size + 2>>())
+    {
+        (*data)[FirstIndex].rightElement = LastIndex;
+        (*data)[LastIndex].leftElement = FirstIndex;
+    }
+    ~CompactHashTable() = default;
+    CompactHashTable(const CompactHashTable &other) = delete;
+    CompactHashTable(CompactHashTable &&other) = delete;
+    CompactHashTable &operator=(const CompactHashTable &other) = delete;
+    CompactHashTable &operator=(CompactHashTable &&other) = delete;
+
+    bool insert(KeyViewType key, const ValueType &value)
+    {
+        uint32_t index = getHash(key);
+        const uint32_t startIndex = index;
+        uint32_t firstErasedIndex = Size;
+        // Walk the whole chain once, the key may exist after an erased slot
+        while ((*data)[index].state != SlotState::Empty)
+        {
+            if ((*data)[index].state == SlotState::Occupied && keysMatch((*data)[index], key))
+            {
+                // Key exists, update value and move it to the beginning of the list
+                (*data)[index].value = value;
+                unlinkElement(index);
+                linkElement(index);
+                return true;
+            }
+            if ((*data)[index].state == SlotState::Erased && firstErasedIndex == Size)
+            {
+                firstErasedIndex = index;
+            }
+            // Linear probing
+            index = (index + ProbingFactor) % Size;
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        if (firstErasedIndex != Size)
+        {
+            index = firstErasedIndex;
+        }
+        else if ((*data)[index].state != SlotState::Empty)
+        {
+            // Table full
+            return false;
+        }
+
+        storeKey((*data)[index], key);
+        (*data)[index].value = value;
+        (*data)[index].state = SlotState::Occupied;
+        ++elementCount;
+        linkElement(index);
+
+        return true;
+    }
+
+    bool remove(KeyViewType key)
+    {
+        const uint32_t index = getIndexFromProbing(key);
+        if (index == Size)
+        {
+            // Key not found
+            return false;
+        }
+
+        // Unlink element from double linked list
+        unlinkElement(index);
+
+        // Set erased in order to not break probing chains
+        (*data)[index].state = SlotState::Erased;
+        releaseKey((*data)[index]);
+        (*data)[index].value = ValueType{};
+        --elementCount;
+
+        return true;
+    }
+
+    std::tuple<bool, ValueType> get(KeyViewType key)
+    {
+        const uint32_t index = getIndexFromProbing(key);
+        if (index == Size)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+
+        // Update LRU linked list since this element was just accessed
+        unlinkElement(index);
+        linkElement(index);
+
+        return std::make_tuple(true, (*data)[index].value);
+    }
+
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        const uint32_t index = (*data)[FirstIndex].rightElement;
+        if (index == LastIndex)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(KeyType(getKey((*data)[index])), (*data)[index].value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        const uint32_t index = (*data)[LastIndex].leftElement;
+        if (index == FirstIndex)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(KeyType(getKey((*data)[index])), (*data)[index].value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    uint32_t getHash(KeyViewType key) const
+    {
+        std::hash<KeyViewType> hasher;
+        return hasher(key) % Size;
+    }
+
+    uint32_t size() const
+    {
+        return elementCount;
+    }
+
+    // Bytes used by the slot array and the side arena of long keys
+    size_t memoryUsage() const
+    {
+        return sizeof(HashElement) * (Size + 2) + keyArena.capacity();
+    }
+
+private:
+    static constexpr uint32_t FirstIndex = Size;
+    static constexpr uint32_t LastIndex = Size + 1;
+    // Key length value of elements whose key is in the side arena
+    static constexpr uint8_t ArenaKey = 0xFF;
+    // Do not compact the arena for a few small holes
+    static constexpr size_t MinimumArenaHoles = 4096;
+
+    enum class SlotState : uint8_t
+    {
+        Empty,
+        Occupied,
+        Erased,
+    };
+
+    // Location of a long key in the side arena, stored in the inline key bytes
+    struct ArenaLocation
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct HashElement
+    {
+        uint32_t rightElement = 0;
+        uint32_t leftElement = 0;
+        ValueType value{};
+        uint8_t keyLength = 0;
+        SlotState state = SlotState::Empty;
+        char key[InlineKeySize] = {};
+    };
+    static_assert(sizeof(ArenaLocation) <= InlineKeySize, "Arena location must fit in the inline key");
+    static_assert(sizeof(HashElement) == 36, "Element layout must stay compact");
+
+    KeyViewType getKey(const HashElement &element) const
+    {
+        if (element.keyLength != ArenaKey)
+        {
+            return KeyViewType(element.key, element.keyLength);
+        }
+        ArenaLocation location{};
+        std::memcpy(&location, element.key, sizeof(location));
+        return KeyViewType(keyArena.data() + location.offset, location.length);
+    }
+
+    void storeKey(HashElement &element, KeyViewType key)
+    {
+        if (key.size() <= InlineKeySize)
+        {
+            std::memcpy(element.key, key.data(), key.size());
+            element.keyLength = static_cast<uint8_t>(key.size());
+            return;
+        }
+        const ArenaLocation location{static_cast<uint32_t>(keyArena.size()), static_cast<uint32_t>(key.size())};
+        keyArena.insert(keyArena.end(), key.begin(), key.end());
+        std::memcpy(element.key, &location, sizeof(location));
+        element.keyLength = ArenaKey;
+    }
+
+    void releaseKey(HashElement &element)
+    {
+        if (element.keyLength == ArenaKey)
+        {
+            ArenaLocation location{};
+            std::memcpy(&location, element.key, sizeof(location));
+            arenaHoles += location.length;
+        }
+        element.keyLength = 0;
+        if (arenaHoles > MinimumArenaHoles && arenaHoles > keyArena.size() / 2)
+        {
+            compactArena();
+        }
+    }
+
+    // Copy the long keys that are still in use to a new arena without holes
+    void compactArena()
+    {
+        std::vector<char> compacted;
+        compacted.reserve(keyArena.size() - arenaHoles);
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            HashElement &element = (*data)[index];
+            if (element.state != SlotState::Occupied || element.keyLength != ArenaKey)
+            {
+                continue;
+            }
+            ArenaLocation location{};
+            std::memcpy(&location, element.key, sizeof(location));
+            const char *begin = keyArena.data() + location.offset;
+            location.offset = static_cast<uint32_t>(compacted.size());
+            compacted.insert(compacted.end(), begin, begin + location.length);
+            std::memcpy(element.key, &location, sizeof(location));
+        }
+        keyArena.swap(compacted);
+        arenaHoles = 0;
+    }
+
+    bool keysMatch(const HashElement &element, KeyViewType key) const
+    {
+        return getKey(element) == key;
+    }
+
+    uint32_t getIndexFromProbing(KeyViewType key) const
+    {
+        uint32_t index = getHash(key);
+        const uint32_t startIndex = index;
+        // Erased slots do not break the probing chain, only an empty slot ends it
+        while ((*data)[index].state != SlotState::Empty)
+        {
+            if ((*data)[index].state == SlotState::Occupied && keysMatch((*data)[index], key))
+            {
+                return index;
+            }
+            // Linear probing
+            index = (index + ProbingFactor) % Size;
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        return Size; // Indicate not found
+    }
+
+    void linkElement(uint32_t index)
+    {
+        // Link this element to the beginning of the list
+        // Left to right connection
+        const uint32_t temp = (*data)[FirstIndex].rightElement;
+        (*data)[FirstIndex].rightElement = index;
+        (*data)[index].rightElement = temp;
+
+        // Right to left connection
+        (*data)[temp].leftElement = index;
+        (*data)[index].leftElement = FirstIndex;
+    }
+
+    void unlinkElement(uint32_t index)
+    {
+        // Unlink the element from the double linked list
+        (*data)[(*data)[index].leftElement].rightElement = (*data)[index].rightElement;
+        (*data)[(*data)[index].rightElement].leftElement = (*data)[index].leftElement;
+    }
+
+    // Slot array with the first and last elements of the double linked list at the end
+    std::unique_ptr<std::array<HashElement, Size + 2>> data;
+
+    // Keys longer than InlineKeySize
+    std::vector<char> keyArena;
+    size_t arenaHoles = 0;
+    uint32_t elementCount = 0;
+};
+
+#endif // COMPACT_HASH_TABLE_H
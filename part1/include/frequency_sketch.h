@@ -0,0 +1,121 @@
+#ifndef FREQUENCY_SKETCH_H
+#define FREQUENCY_SKETCH_H
+
+#include <cstdint>
+#include <memory>
+
+#include "hash_functions.h"
+
+// Approximate access counts of keys in a fixed amount of memory, used by the frequency admission filter of
+// HashTable (TinyLFU).
+//
+// How counting works:
+// 1. The sketch is a count-min sketch of 4 rows of 4-bit counters, 16 counters packed in every 64-bit word. A
+// row has 4 counters per slot of the table rounded up to a power of two, so keys rarely share a counter in all
+// rows. The sketch takes 8 bytes per slot and nothing is added to the elements.
+//
+// 2. The hash of a key is mixed with a different seed for every row to choose one counter per row. Incrementing
+// increases the 4 counters up to their maximum of 15 and the estimate is the smallest of them, since other keys
+// can only have added to a counter.
+//
+// 3. After 10 increments per slot every counter is halved (aging), so keys that were popular long ago lose
+// their count and the sketch follows changes of the working set.
+class FrequencySketch
+{
+public:
+    static constexpr uint32_t RowCount = 4;
+    static constexpr uint32_t MaxCount = 15;
+    // Counters of a row per slot of the table
+    static constexpr uint32_t CountersPerSlot = 4;
+    // Increments per slot of the table between two halvings of the counters
+    static constexpr uint32_t SamplesPerSlot = 10;
+
+    explicit FrequencySketch(uint32_t capacity)
+        : rowCounters(roundUpToPowerOfTwo(static_cast<uint64_t>(capacity) * CountersPerSlot)),
+          wordCount(RowCount * rowCounters / CountersPerWord), words(std::make_unique<uint64_t[]>(wordCount)),
+          sampleSize(static_cast<uint64_t>(capacity) * SamplesPerSlot)
+    {
+    }
+    ~FrequencySketch() = default;
+    FrequencySketch(const FrequencySketch &other) = delete;
+    FrequencySketch(FrequencySketch &&other) = delete;
+    FrequencySketch &operator=(const FrequencySketch &other) = delete;
+    FrequencySketch &operator=(FrequencySketch &&other) = delete;
+
+    // Count one access of the key with this hash
+    void increment(uint64_t keyHash)
+    {
+        for (uint32_t row = 0; row < RowCount; ++row)
+        {
+            const uint32_t counter = getCounterIndex(keyHash, row);
+            uint64_t &word = words[counter / CountersPerWord];
+            const uint32_t shift = (counter % CountersPerWord) * CounterBits;
+            if (((word >> shift) & MaxCount) != MaxCount)
+            {
+                word += uint64_t{1} << shift;
+            }
+        }
+        if (++additions >= sampleSize)
+        {
+            halve();
+        }
+    }
+
+    // Estimated number of accesses of the key since the last halvings, at most MaxCount
+    uint32_t estimate(uint64_t keyHash) const
+    {
+        uint32_t smallest = MaxCount;
+        for (uint32_t row = 0; row < RowCount; ++row)
+        {
+            const uint32_t counter = getCounterIndex(keyHash, row);
+            const uint64_t word = words[counter / CountersPerWord];
+            const auto count = static_cast<uint32_t>((word >> ((counter % CountersPerWord) * CounterBits)) & MaxCount);
+            smallest = count < smallest ? count : smallest;
+        }
+        return smallest;
+    }
+
+private:
+    static constexpr uint32_t CounterBits = 4;
+    static constexpr uint32_t CountersPerWord = 64 / CounterBits;
+    // The highest bit of every counter, cleared after shifting all counters of a word right by one
+    static constexpr uint32_t MaxRowCounters = 1U << 28;
+    static constexpr uint64_t HalfMask = 0x7777777777777777ULL;
+    static constexpr uint64_t RowSeeds[RowCount] = {0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+                                                    0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL};
+
+    // At least one word per row and at most MaxRowCounters
+    static uint32_t roundUpToPowerOfTwo(uint64_t value)
+    {
+        uint32_t result = CountersPerWord;
+        while (result < value && result < MaxRowCounters)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    uint32_t getCounterIndex(uint64_t keyHash, uint32_t row) const
+    {
+        const uint64_t rowHash = hash_functions::multiplyMix(keyHash ^ RowSeeds[row], hash_functions::Prime1);
+        return row * rowCounters + static_cast<uint32_t>(rowHash & (rowCounters - 1));
+    }
+
+    void halve()
+    {
+        for (uint32_t i = 0; i < wordCount; ++i)
+        {
+            words[i] = (words[i] >> 1) & HalfMask;
+        }
+        additions /= 2;
+    }
+
+    // Counters per row, a power of two
+    uint32_t rowCounters;
+    uint32_t wordCount;
+    std::unique_ptr<uint64_t[]> words;
+    uint64_t sampleSize;
+    uint64_t additions = 0;
+};
+
+#endif // FREQUENCY_SKETCH_H
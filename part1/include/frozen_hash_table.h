@@ -0,0 +1,240 @@
+#ifndef FROZEN_HASH_TABLE_H
+#define FROZEN_HASH_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+// Read only table of a key set that is known at build time, such as field or symbol names, built at compile
+// time with a minimal perfect hash. A lookup hashes the key once, reads one displacement and one slot and compares
+// one key, there is no probing and nothing is written.
+//
+// How the perfect hash works (hash and displace, CHD):
+// 1. Every key is hashed once with 64-bit FNV-1a, which can be computed in a constant expression. The hash
+// chooses one of N buckets.
+//
+// 2. The buckets are placed from the largest to the smallest. For every bucket the displacement 1, 2, 3, ... is
+// tried until all its keys land on free slots, the slot of a key is its hash mixed with the displacement of its
+// bucket modulo N. There are as many slots as keys, so the hash is minimal.
+//
+// 3. A lookup of any key computes its slot from the displacement of its bucket. A key that is not in the set
+// lands on some slot too, so the key of the slot is compared before returning its value.
+//
+// The search runs in the constructor, a constexpr table is built by the compiler and a duplicate key fails the
+// build. Building takes about N^2 steps in the worst case, which is meant for key sets of up to a few hundred
+// keys.
+//
+//     constexpr std::array<std::pair<std::string_view, uint32_t>, 3> Fields = {{{"a", 0}, {"p", 1}, {"q", 2}}};
+//     constexpr FrozenHashTable fieldTable(Fields);
+//     static_assert(std::get<1>(fieldTable.get("p")) == 1);
+template<typename Value, size_t N>
+class FrozenHashTable
+{
+public:
+    using KeyViewType = std::string_view;
+    using ValueType = Value;
+    using Entry = std::pair<KeyViewType, ValueType>;
+    static_assert(N > 0, "A frozen table needs at least one key");
+    static_assert(N <= UINT32_MAX, "Slots are indexed with 32 bits");
+    // Displacements tried per bucket before giving up, a bucket of distinct keys needs about N tries at most
+    static constexpr uint32_t MaxDisplacement = 1U << 16;
+
+    constexpr explicit FrozenHashTable(const std::array<Entry, N> &entries)
+    {
+        // Hash every key and group the key indices by bucket (counting sort)
+        std::array<uint64_t, N> hashes{};
+        std::array<uint32_t, N + 1> bucketStart{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            hashes[i] = hashKey(entries[i].first);
+            ++bucketStart[getBucket(hashes[i]) + 1];
+        }
+        for (size_t bucket = 0; bucket < N; ++bucket)
+        {
+            bucketStart[bucket + 1] += bucketStart[bucket];
+        }
+        std::array<uint32_t, N> members{};
+        std::array<uint32_t, N> filled{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            const uint32_t bucket = getBucket(hashes[i]);
+            members[bucketStart[bucket] + filled[bucket]++] = static_cast<uint32_t>(i);
+        }
+        // Equal keys are in the same bucket and no displacement can separate them
+        for (size_t bucket = 0; bucket < N; ++bucket)
+        {
+            for (uint32_t first = bucketStart[bucket]; first < bucketStart[bucket + 1]; ++first)
+            {
+                for (uint32_t second = first + 1; second < bucketStart[bucket + 1]; ++second)
+                {
+                    if (entries[members[first]].first == entries[members[second]].first)
+                    {
+                        throw std::logic_error("FrozenHashTable keys must be unique");
+                    }
+                }
+            }
+        }
+
+        // Largest buckets first, they are the hardest to place (insertion sort, N is small)
+        std::array<uint32_t, N> order{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            uint32_t bucket = static_cast<uint32_t>(i);
+            size_t position = i;
+            while (position > 0 && getBucketSize(bucketStart, order[position - 1]) < getBucketSize(bucketStart, bucket))
+            {
+                order[position] = order[position - 1];
+                --position;
+            }
+            order[position] = bucket;
+        }
+
+        std::array<bool, N> taken{};
+        std::array<uint32_t, N> candidateSlots{};
+        for (const uint32_t bucket : order)
+        {
+            const uint32_t bucketSize = getBucketSize(bucketStart, bucket);
+            if (bucketSize == 0)
+            {
+                // Sorted by size, every remaining bucket is empty
+                break;
+            }
+            uint32_t displacement = 1;
+            while (!tryPlace(hashes, members, bucketStart[bucket], bucketSize, displacement, taken, candidateSlots))
+            {
+                if (++displacement == MaxDisplacement)
+                {
+                    throw std::logic_error("FrozenHashTable found no perfect hash for the keys");
+                }
+            }
+            displacements[bucket] = displacement;
+            for (uint32_t member = 0; member < bucketSize; ++member)
+            {
+                const uint32_t slot = candidateSlots[member];
+                taken[slot] = true;
+                keys[slot] = entries[members[bucketStart[bucket] + member]].first;
+                values[slot] = entries[members[bucketStart[bucket] + member]].second;
+            }
+        }
+    }
+    ~FrozenHashTable() = default;
+    FrozenHashTable(const FrozenHashTable &other) = delete;
+    FrozenHashTable(FrozenHashTable &&other) = delete;
+    FrozenHashTable &operator=(const FrozenHashTable &other) = delete;
+    FrozenHashTable &operator=(FrozenHashTable &&other) = delete;
+
+    constexpr std::tuple<bool, ValueType> get(KeyViewType key) const
+    {
+        const uint32_t slot = getSlotOfKey(key);
+        if (keys[slot] != key)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+        return std::make_tuple(true, values[slot]);
+    }
+
+    // Pointer to the value of the key, nullptr if the key is not in the set
+    constexpr const ValueType *find(KeyViewType key) const
+    {
+        const uint32_t slot = getSlotOfKey(key);
+        return keys[slot] == key ? &values[slot] : nullptr;
+    }
+
+    constexpr bool contains(KeyViewType key) const
+    {
+        return keys[getSlotOfKey(key)] == key;
+    }
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+private:
+    static constexpr uint64_t FnvOffset = 0xcbf29ce484222325ULL;
+    static constexpr uint64_t FnvPrime = 0x100000001b3ULL;
+
+    static constexpr uint64_t hashKey(KeyViewType key)
+    {
+        uint64_t hash = FnvOffset;
+        for (const char c : key)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= FnvPrime;
+        }
+        return hash;
+    }
+
+    // Finalizer of MurmurHash3, every bit of the displaced hash affects the slot
+    static constexpr uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return value;
+    }
+
+    static constexpr uint32_t getBucket(uint64_t hash)
+    {
+        return static_cast<uint32_t>((hash >> 32) % N);
+    }
+
+    static constexpr uint32_t getSlot(uint64_t hash, uint32_t displacement)
+    {
+        return static_cast<uint32_t>(mix(hash ^ (displacement * 0x9e3779b97f4a7c15ULL)) % N);
+    }
+
+    static constexpr uint32_t getBucketSize(const std::array<uint32_t, N + 1> &bucketStart, uint32_t bucket)
+    {
+        return bucketStart[bucket + 1] - bucketStart[bucket];
+    }
+
+    // Compute the slots of the keys of a bucket with a displacement into candidateSlots, false if one of them is
+    // taken or two of them collide
+    static constexpr bool tryPlace(const std::array<uint64_t, N> &hashes, const std::array<uint32_t, N> &members,
+                                   uint32_t firstMember, uint32_t bucketSize, uint32_t displacement,
+                                   const std::array<bool, N> &taken, std::array<uint32_t, N> &candidateSlots)
+    {
+        for (uint32_t member = 0; member < bucketSize; ++member)
+        {
+            const uint32_t slot = getSlot(hashes[members[firstMember + member]], displacement);
+            if (taken[slot])
+            {
+                return false;
+            }
+            for (uint32_t previous = 0; previous < member; ++previous)
+            {
+                if (candidateSlots[previous] == slot)
+                {
+                    return false;
+                }
+            }
+            candidateSlots[member] = slot;
+        }
+        return true;
+    }
+
+    constexpr uint32_t getSlotOfKey(KeyViewType key) const
+    {
+        const uint64_t hash = hashKey(key);
+        return getSlot(hash, displacements[getBucket(hash)]);
+    }
+
+    // Displacement of every bucket, 0 for empty buckets
+    std::array<uint32_t, N> displacements{};
+    // Key and value of every slot
+    std::array<KeyViewType, N> keys{};
+    std::array<ValueType, N> values{};
+};
+
+template<typename Value, size_t N>
+FrozenHashTable(const std::array<std::pair<std::string_view, Value>, N> &) -> FrozenHashTable<Value, N>;
+
+#endif // FROZEN_HASH_TABLE_H
@@ -0,0 +1,419 @@
+#ifndef GROWABLE_HASH_TABLE_H
+#define GROWABLE_HASH_TABLE_H
+
+#include <sys/types.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// Hash Table with LRU/MRU ordering whose capacity is chosen at runtime and which grows when the load factor
+// exceeds a threshold. It has the same interface and the same double linked list as HashTable<Size>, but
+// instead of failing when the table gets full it allocates a bigger slot array and moves the elements into it.
+//
+// How growing works:
+// 1. When an insert would exceed the maximum load factor a new slot array is allocated. The capacity is always
+// a power of two so the hash can be mapped to an index with a mask instead of a modulo.
+//
+// 2. The old slot array is not rehashed at once. Every following insert, get and remove moves a small number
+// of old elements (MigrationStep) into the new array and looks at no more than MigrationScanLimit old slots, so
+// there is never a single long stall, not even over a sparse or tombstone heavy old array.
+//
+// 3. While migrating, lookups check the new array first and then the old one. Inserts always go to the new
+// array. Moved slots are marked as erased in the old array so its probing chains stay valid.
+//
+// 4. When an element is moved, its left and right neighbours in the double linked list are pointed to the
+// new location, so the LRU/MRU order is not affected by the move.
+class GrowableHashTable
+{
+public:
+    using KeyType = std::string;
+    using ValueType = uint32_t;
+    using KeyValuePair = std::tuple<KeyType, ValueType>;
+    static constexpr uint32_t ProbingFactor = 1;
+    // Number of old elements moved to the new slot array on every operation while growing
+    static constexpr uint32_t MigrationStep = 16;
+    // Number of old slots looked at on every operation while growing, used or not
+    static constexpr uint32_t MigrationScanLimit = 4 * MigrationStep;
+    static constexpr uint32_t MinimumCapacity = 8;
+
+    explicit GrowableHashTable(uint32_t initialCapacity = MinimumCapacity, float maxLoadFactor = 0.75F)
+        : maxLoadFactor(maxLoadFactor)
+    {
+        firstElement.rightElement = &lastElement;
+        firstElement.leftElement = nullptr;
+        lastElement.rightElement = nullptr;
+        lastElement.leftElement = &firstElement;
+        allocateSlots(data, roundUpToPowerOfTwo(initialCapacity));
+    }
+    ~GrowableHashTable() = default;
+    GrowableHashTable(const GrowableHashTable &other) = delete;
+    GrowableHashTable(GrowableHashTable &&other) = delete;
+    GrowableHashTable &operator=(const GrowableHashTable &other) = delete;
+    GrowableHashTable &operator=(GrowableHashTable &&other) = delete;
+
+    bool insert(const KeyType &key, const ValueType &value)
+    {
+        migrateStep();
+
+        // If the key still lives in the old slot array move it first, so it is updated in one place only
+        if (isMigrating())
+        {
+            const uint32_t oldIndex = getIndexFromProbing(oldData, key);
+            if (oldIndex != oldData.capacity)
+            {
+                migrateSlot(oldIndex);
+            }
+        }
+
+        uint32_t index = getIndexFromProbing(data, key);
+        if (index == data.capacity)
+        {
+            // New key, grow first if this insert exceeds the load factor
+            if (exceedsLoadFactor(data.occupied + data.erased + 1))
+            {
+                startGrowing();
+            }
+            index = getFreeIndex(data, key);
+            if (index == data.capacity)
+            {
+                // Can only happen if the capacity cannot grow any more
+                return false;
+            }
+            if (data.slots[index].erased)
+            {
+                data.slots[index].erased = false;
+                --data.erased;
+            }
+            data.slots[index].key = key;
+            ++data.occupied;
+        }
+        else
+        {
+            unlinkElement(data.slots[index]);
+        }
+        data.slots[index].value = value;
+        linkElement(data.slots[index]);
+
+        return true;
+    }
+
+    bool remove(const KeyType &key)
+    {
+        migrateStep();
+
+        SlotArray *table = &data;
+        uint32_t index = getIndexFromProbing(data, key);
+        if (index == data.capacity && isMigrating())
+        {
+            table = &oldData;
+            index = getIndexFromProbing(oldData, key);
+        }
+        if (index == table->capacity)
+        {
+            // Key not found
+            return false;
+        }
+
+        // Unlink element from double linked list and leave a tombstone so to not break probing chains
+        unlinkElement(table->slots[index]);
+        eraseSlot(*table, index);
+
+        return true;
+    }
+
+    std::tuple<bool, ValueType> get(const KeyType &key)
+    {
+        migrateStep();
+
+        uint32_t index = getIndexFromProbing(data, key);
+        if (index == data.capacity && isMigrating())
+        {
+            // Still in the old slot array, move it now since it is being accessed
+            const uint32_t oldIndex = getIndexFromProbing(oldData, key);
+            if (oldIndex != oldData.capacity)
+            {
+                index = migrateSlot(oldIndex);
+            }
+        }
+        if (index == data.capacity)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+
+        // Update LRU linked list since this element was just accessed
+        unlinkElement(data.slots[index]);
+        linkElement(data.slots[index]);
+
+        return std::make_tuple(true, data.slots[index].value);
+    }
+
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        if (firstElement.rightElement == &lastElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(firstElement.rightElement->key, firstElement.rightElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        if (lastElement.leftElement == &firstElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(lastElement.leftElement->key, lastElement.leftElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    // Number of stored keys in both slot arrays
+    uint32_t size() const
+    {
+        return data.occupied + (isMigrating() ? oldData.occupied : 0);
+    }
+
+    // Capacity of the slot array new keys are inserted into
+    uint32_t capacity() const
+    {
+        return data.capacity;
+    }
+
+    float loadFactor() const
+    {
+        return static_cast<float>(size()) / static_cast<float>(data.capacity);
+    }
+
+    bool isMigrating() const
+    {
+        return oldData.slots != nullptr;
+    }
+
+private:
+    struct HashElement
+    {
+        HashElement *rightElement = nullptr;
+        HashElement *leftElement = nullptr;
+        ValueType value{};
+        KeyType key{};
+        bool erased = false;
+    };
+    using HashElementPtr = HashElement *;
+
+    struct SlotArray
+    {
+        std::unique_ptr<HashElement[]> slots;
+        uint32_t capacity = 0;
+        uint32_t mask = 0;
+        uint32_t occupied = 0;
+        uint32_t erased = 0;
+    };
+
+    static uint32_t roundUpToPowerOfTwo(uint32_t value)
+    {
+        uint32_t capacity = MinimumCapacity;
+        while (capacity < value && capacity < (1U << 31))
+        {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    static void allocateSlots(SlotArray &table, uint32_t capacity)
+    {
+        table.slots = std::make_unique<HashElement[]>(capacity);
+        table.capacity = capacity;
+        table.mask = capacity - 1;
+        table.occupied = 0;
+        table.erased = 0;
+    }
+
+    uint32_t getHash(const SlotArray &table, const KeyType &key) const
+    {
+        std::hash<KeyType> hasher;
+        return static_cast<uint32_t>(hasher(key)) & table.mask;
+    }
+
+    bool exceedsLoadFactor(uint32_t usedSlots) const
+    {
+        return static_cast<float>(usedSlots) > maxLoadFactor * static_cast<float>(data.capacity);
+    }
+
+    // Since we use first and last elements in the double linked list to avoid edge cases,
+    // an element is occupied if both left and right pointers are not null
+    static bool isOccupied(const HashElement &element)
+    {
+        return element.rightElement != nullptr && element.leftElement != nullptr;
+    }
+
+    uint32_t getIndexFromProbing(const SlotArray &table, const KeyType &key) const
+    {
+        uint32_t index = getHash(table, key);
+        const uint32_t startIndex = index;
+        // Walk the chain until we hit a slot that was never used, erased slots do not end the chain
+        while (isOccupied(table.slots[index]) || table.slots[index].erased)
+        {
+            if (isOccupied(table.slots[index]) && table.slots[index].key == key)
+            {
+                return index;
+            }
+            // Linear probing
+            index = (index + ProbingFactor) & table.mask;
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        return table.capacity; // Indicate not found
+    }
+
+    // Find the first slot that is either unused or erased for a key that is known to not exist in the table
+    uint32_t getFreeIndex(const SlotArray &table, const KeyType &key) const
+    {
+        uint32_t index = getHash(table, key);
+        const uint32_t startIndex = index;
+        while (isOccupied(table.slots[index]))
+        {
+            index = (index + ProbingFactor) & table.mask;
+            if (index == startIndex)
+            {
+                // Table full
+                return table.capacity;
+            }
+        }
+        return index;
+    }
+
+    static void eraseSlot(SlotArray &table, uint32_t index)
+    {
+        table.slots[index].erased = true;
+        table.slots[index].key.clear();
+        table.slots[index].value = ValueType{};
+        --table.occupied;
+        ++table.erased;
+    }
+
+    void startGrowing()
+    {
+        // A previous migration is still running, this only happens if the table is filled faster than it is
+        // migrated. Spend one more step on it instead of draining it and grow once it is done. Every step looks
+        // at MigrationStep old slots at least and the new array has room for every old element plus one insert
+        // per MigrationStep old slots, so the new array cannot fill up before the migration ends.
+        if (isMigrating())
+        {
+            migrateStep();
+            if (isMigrating())
+            {
+                return;
+            }
+        }
+
+        // If most used slots are tombstones rehash into the same capacity to clean them up instead of growing
+        uint32_t newCapacity = data.capacity;
+        if (exceedsLoadFactor(data.occupied * 2) && data.capacity < (1U << 31))
+        {
+            newCapacity = data.capacity << 1;
+        }
+
+        oldData = std::move(data);
+        allocateSlots(data, newCapacity);
+        migrationIndex = 0;
+    }
+
+    void migrateStep()
+    {
+        if (!isMigrating())
+        {
+            return;
+        }
+        uint32_t moved = 0;
+        const uint32_t remaining = oldData.capacity - migrationIndex;
+        const uint32_t scanEnd = remaining > MigrationScanLimit ? migrationIndex + MigrationScanLimit : oldData.capacity;
+        while (migrationIndex < scanEnd && moved < MigrationStep)
+        {
+            if (isOccupied(oldData.slots[migrationIndex]))
+            {
+                migrateSlot(migrationIndex);
+                ++moved;
+            }
+            ++migrationIndex;
+        }
+        if (migrationIndex == oldData.capacity)
+        {
+            // Every element has been moved, release the old slot array
+            oldData = SlotArray{};
+        }
+    }
+
+    // Move an occupied element of the old slot array into the new one and return its new index
+    uint32_t migrateSlot(uint32_t oldIndex)
+    {
+        HashElement &source = oldData.slots[oldIndex];
+        const uint32_t index = getFreeIndex(data, source.key);
+        HashElement &target = data.slots[index];
+        if (target.erased)
+        {
+            target.erased = false;
+            --data.erased;
+        }
+        target.key = std::move(source.key);
+        target.value = source.value;
+        ++data.occupied;
+
+        // Take over the position of the source element in the double linked list
+        target.leftElement = source.leftElement;
+        target.rightElement = source.rightElement;
+        target.leftElement->rightElement = &target;
+        target.rightElement->leftElement = &target;
+        source.leftElement = nullptr;
+        source.rightElement = nullptr;
+
+        eraseSlot(oldData, oldIndex);
+        return index;
+    }
+
+    void linkElement(HashElement &element)
+    {
+        // Link this element to the beginning of the list
+        // Left to right connection
+        HashElementPtr temp = firstElement.rightElement;
+        firstElement.rightElement = &element;
+        element.rightElement = temp;
+
+        // Right to left connection
+        temp->leftElement = &element;
+        element.leftElement = &firstElement;
+    }
+
+    void unlinkElement(HashElement &element)
+    {
+        // Element must be occupied to be unlinked
+        if (!isOccupied(element))
+        {
+            return;
+        }
+        element.leftElement->rightElement = element.rightElement;
+        element.rightElement->leftElement = element.leftElement;
+
+        // Set null the links of the node to remove so to become unoccupied
+        element.leftElement = nullptr;
+        element.rightElement = nullptr;
+    }
+
+    // Use if first and last elements to avoid edges cases
+    HashElement firstElement{};
+    HashElement lastElement{};
+
+    // Slot array new keys are inserted into and the slot array being drained while growing
+    SlotArray data;
+    SlotArray oldData;
+    uint32_t migrationIndex = 0;
+    float maxLoadFactor;
+};
+
+#endif // GROWABLE_HASH_TABLE_H
@@ -0,0 +1,121 @@
+#ifndef HASH_FUNCTIONS_H
+#define HASH_FUNCTIONS_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Fast non-cryptographic hash functions for the hash tables.
+//
+// The string hash reads the key 16 bytes at a time and mixes them with a 64x64 -> 128 bit multiplication
+// where the high and low halves are xored together (the wyhash construction). Keys of up to 16 bytes are
+// read with at most four overlapping loads and no loop. Integer keys are mixed with a single multiplication.
+// The result is the same on every run and in every process, unlike std::hash which is only required to be
+// consistent within one execution.
+namespace hash_functions
+{
+constexpr uint64_t Prime0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t Prime1 = 0xe7037ed1a0b428dbULL;
+
+inline uint64_t multiplyMix(uint64_t a, uint64_t b)
+{
+    const __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t read64(const char *p)
+{
+    uint64_t value = 0;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t read32(const char *p)
+{
+    uint32_t value = 0;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t hashBytes(const char *data, size_t length, uint64_t seed = 0)
+{
+    seed ^= Prime0;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            // Two pairs of 4 byte loads cover every length from 4 to 16, the loads can overlap
+            const size_t offset = (length >> 3) << 2;
+            a = (read32(data) << 32) | read32(data + offset);
+            b = (read32(data + length - 4) << 32) | read32(data + length - 4 - offset);
+        }
+        else if (length > 0)
+        {
+            a = (static_cast<uint64_t>(static_cast<uint8_t>(data[0])) << 16) |
+                (static_cast<uint64_t>(static_cast<uint8_t>(data[length >> 1])) << 8) |
+                static_cast<uint64_t>(static_cast<uint8_t>(data[length - 1]));
+        }
+    }
+    else
+    {
+        size_t remaining = length;
+        while (remaining > 16)
+        {
+            seed = multiplyMix(read64(data) ^ Prime1, read64(data + 8) ^ seed);
+            data += 16;
+            remaining -= 16;
+        }
+        // Last 16 bytes, they may overlap with the bytes already mixed
+        a = read64(data + remaining - 16);
+        b = read64(data + remaining - 8);
+    }
+    return multiplyMix(Prime1 ^ length, multiplyMix(a ^ Prime1, b ^ seed));
+}
+
+inline uint64_t hashInteger(uint64_t value)
+{
+    return multiplyMix(value ^ Prime0, Prime1);
+}
+} // namespace hash_functions
+
+// Type the hash tables take keys as in lookups. Strings are looked up with a view so that callers with only a
+// range of characters do not need to build a std::string. Small trivially copyable keys are passed by value.
+template<typename Key>
+struct KeyTraits
+{
+    using ViewType = std::conditional_t<std::is_trivially_copyable<Key>::value && sizeof(Key) <= 16, Key, const Key &>;
+};
+
+template<>
+struct KeyTraits<std::string>
+{
+    using ViewType = std::string_view;
+};
+
+// Default hasher of the hash tables, specialized for strings and integers
+template<typename Key, typename Enable = void>
+struct DefaultHasher;
+
+template<>
+struct DefaultHasher<std::string>
+{
+    size_t operator()(std::string_view key) const
+    {
+        return hash_functions::hashBytes(key.data(), key.size());
+    }
+};
+
+template<typename Key>
+struct DefaultHasher<Key, std::enable_if_t<std::is_integral<Key>::value || std::is_enum<Key>::value>>
+{
+    size_t operator()(Key key) const
+    {
+        return hash_functions::hashInteger(static_cast<uint64_t>(key));
+    }
+};
+
+#endif // HASH_FUNCTIONS_H
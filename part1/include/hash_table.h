@@ -3,28 +3,121 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <new>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "frequency_sketch.h"
+#include "hash_functions.h"
+#include "hash_table_snapshot.h"
+#include "hash_table_stats.h"
+#include "page_allocation.h"
+#include "timing_wheel.h"
 
 typedef __uint32_t uint32_t;
 
-template<uint32_t Size>
+// What insert does when a new key does not fit in the table
+enum class CapacityPolicy
+{
+    // Insert fails and returns false
+    RejectWhenFull,
+    // The least recently used element (the one returned by get_first) is evicted and its slot is reused
+    EvictLeastRecentlyUsed,
+};
+
+// How accesses update the LRU/MRU order
+enum class RecencyPolicy
+{
+    // Every access moves the element to the beginning of the double linked list
+    Exact,
+    // An access only sets a reference bit of the element (CLOCK / second chance). Elements stay in insertion
+    // order and a referenced element gets a second chance when it reaches the end of the list: its bit is
+    // cleared and it is moved to the beginning. Hits write nothing if the bit is already set.
+    Clock,
+};
+
+// Whether a new key may evict an element when the table is full, only used with EvictLeastRecentlyUsed
+enum class AdmissionPolicy
+{
+    // Every new key evicts the least recently used element
+    AdmitAll,
+    // TinyLFU. Accesses of get, upsert and find_or_insert are counted in a FrequencySketch and a new key only
+    // evicts the least recently used element if it was accessed more often, so a scan of keys that are used once
+    // cannot flush the frequently used ones. A key that is not admitted is not inserted.
+    FrequencyFilter,
+};
+
+struct HashTableOptions
+{
+    CapacityPolicy capacityPolicy = CapacityPolicy::RejectWhenFull;
+    RecencyPolicy recencyPolicy = RecencyPolicy::Exact;
+    AdmissionPolicy admissionPolicy = AdmissionPolicy::AdmitAll;
+    // Pages of the slot array, see page_allocation.h. Huge pages are only used for arrays of at least 2 MiB.
+    PagePolicy pagePolicy = PagePolicy::Default;
+    // Fault in every page of the slot array in one call at construction instead of page by page
+    bool prefault = false;
+    // Bytes the weights of the elements may add up to, 0 for no budget. Inserts that go over the budget evict
+    // least recently used elements until the table fits again, in every capacity policy.
+    uint64_t byteBudget = 0;
+    // Milliseconds of a monotonic clock used for TTLs, std::chrono::steady_clock if not set
+    std::function<uint64_t()> ttlClock = nullptr;
+};
+
+// Key, value and hasher are template parameters. The hasher is called with KeyViewType and must return the full
+// hash of the key. When Size is a power of two the hash is mapped to a slot with a mask instead of a modulo.
+// Stats is NoHashTableStats or HashTableStats from hash_table_stats.h, see statistics().
+template<uint32_t Size, typename Key = std::string, typename Value = uint32_t, typename Hasher = DefaultHasher<Key>,
+         typename Stats = NoHashTableStats>
 class HashTable
 {
 public:
-    using KeyType = std::string;
-    using ValueType = uint32_t;
+    using KeyType = Key;
+    // Lookups take a view so that callers with a char range do not need to build a std::string
+    using KeyViewType = typename KeyTraits<KeyType>::ViewType;
+    using ValueType = Value;
     using KeyValuePair = std::tuple<KeyType, ValueType>;
+    using HasherType = Hasher;
+    // Called with the key and value of an element right before it is evicted
+    using EvictionCallback = std::function<void(const KeyType &, const ValueType &)>;
+    // Bytes an element counts against the byte budget, the key length plus the value size if not set. It takes
+    // the view so that a new key is weighed before it is built.
+    using WeightFunction = std::function<uint32_t(KeyViewType, const ValueType &)>;
     static constexpr uint32_t ProbingFactor = 1;
+    static constexpr uint32_t SlotCount = Size;
+    static constexpr bool IsPowerOfTwo = (Size & (Size - 1)) == 0;
+    // Keys as stored in a batch, KeyViewType without a reference
+    using KeyBatchType = std::remove_cv_t<std::remove_reference_t<KeyViewType>>;
+    // Number of keys hashed and prefetched ahead of the key being probed in batch operations
+    static constexpr uint32_t PrefetchDistance = 16;
+
+    HashTable() : HashTable(HashTableOptions{}) {}
 
-    HashTable() : data(std::make_unique<std::array<HashElement, Size>>())
+    explicit HashTable(const HashTableOptions &options, EvictionCallback onEviction = nullptr,
+                       WeightFunction weigh = nullptr)
+        : options(options), onEviction(std::move(onEviction)), weigh(std::move(weigh)),
+          data(allocateSlots(options))
     {
         firstElement.rightElement = &lastElement;
         firstElement.leftElement = nullptr;
         lastElement.rightElement = nullptr;
         lastElement.leftElement = &firstElement;
+        stats.setCapacity(Size);
+        if (options.admissionPolicy == AdmissionPolicy::FrequencyFilter)
+        {
+            sketch = std::make_unique<FrequencySketch>(Size);
+        }
     }
     ~HashTable() = default;
     HashTable(const HashTable &other) = delete;
@@ -32,66 +125,116 @@ public:
     HashTable &operator=(const HashTable &other) = delete;
     HashTable &operator=(HashTable &&other) = delete;
 
-    bool insert(const KeyType &key, const ValueType &value)
+    bool insert(KeyViewType key, const ValueType &value)
     {
-        // Get hash index
-        uint32_t index = getHash(key);
-        const uint32_t startIndex = index;
-        // We dont care if the element is erased or not we just need to find the next free slot
-        while (isOccupied(index) && !keysMatch((*data)[index].key, key))
+        return upsert(key, value, hashKey(key));
+    }
+
+    // Insert the key or overwrite its value, walking the probing chain only once
+    bool upsert(KeyViewType key, const ValueType &value)
+    {
+        return upsert(key, value, hashKey(key));
+    }
+
+    bool upsert(KeyViewType key, const ValueType &value, size_t keyHash)
+    {
+        const uint32_t index = findOrInsertIndex(key, keyHash, value);
+        if (index == Size)
         {
-            // Linear probing
-            index = (index + ProbingFactor) % Size;
-            if (index == startIndex)
-            {
-                // Table full
-                return false;
-            }
+            // Table full
+            return false;
         }
         (*data)[index].value = value;
-        (*data)[index].key = key;
+        // The default weight does not depend on the value
+        return !weigh || chargeWeight(index);
+    }
 
-        // If previously erased, reset erased flag
-        if ((*data)[index].erased)
+    // Insert or update the key and let it expire ttl from now, replacing a previous TTL of the key. TTLs are
+    // tracked in milliseconds, at least 1. Expired elements are removed by the next get, insert or remove, a
+    // call to expire(), or on their own lookup. Inserting without a TTL keeps the TTL the key already has.
+    bool insert(KeyViewType key, const ValueType &value, std::chrono::milliseconds ttl)
+    {
+        const size_t keyHash = hashKey(key);
+        const uint32_t index = findOrInsertIndex(key, keyHash, value);
+        if (index == Size)
         {
-            (*data)[index].erased = false;
+            // Table full
+            return false;
         }
+        (*data)[index].value = value;
+        if (weigh && !chargeWeight(index))
+        {
+            // Heavier than the byte budget
+            return false;
+        }
+        TimingWheel &wheel = getTimingWheel();
+        const uint64_t ttlTicks = ttl.count() > 0 ? static_cast<uint64_t>(ttl.count()) : 1;
+        wheel.schedule(index, wheel.now() + ttlTicks);
+        return true;
+    }
 
-        // Link this element to the beginning of the list
-        // First unlink in case it was already occupied meaning that the keys matched
-        unlinkElement(index);
-        linkElement(index);
+    // Remove the elements whose TTL has passed. The same happens at the beginning of get, insert and remove,
+    // every element is visited once when it expires and a few times before when it moves between the levels of
+    // the timing wheel, never by a sweep of the table.
+    void expire()
+    {
+        if (ttlWheel)
+        {
+            ttlWheel->advance(getTime(), [this](uint32_t index) { expireElement(index); });
+        }
+    }
 
-        return true;
+    // Return a pointer to the value of the key, inserting the key with a default value if it does not exist.
+    // The key is only copied into the table when it is new. Returns nullptr if the key is new and the table is
+    // full, or the frequency filter did not admit it. keyHash must be the result of hashKey(key), it can be
+    // computed once and reused by the caller. A new key is weighed with the default value, changing the value
+    // through the pointer does not weigh the element again.
+    ValueType *find_or_insert(KeyViewType key)
+    {
+        return find_or_insert(key, hashKey(key));
     }
 
-    bool remove(const KeyType &key)
+    ValueType *find_or_insert(KeyViewType key, size_t keyHash)
     {
+        const uint32_t index = findOrInsertIndex(key, keyHash);
+        return index == Size ? nullptr : &(*data)[index].value;
+    }
+
+
+    bool remove(KeyViewType key)
+    {
+        return remove(key, hashKey(key));
+    }
+
+    bool remove(KeyViewType key, size_t keyHash)
+    {
+        expire();
         // Get coorect index from probing
-        uint32_t index = getIndexFromProbing(key);
+        uint32_t index = getIndexFromProbing(key, keyHash);
         if (index == Size)
         {
             // Key not found
             return false;
         }
 
-        // Unlink element from double linked list
-        unlinkElement(index);
-
-        // Set erased as true in order to not break probing chains
-        (*data)[index].erased = true;
-
-        // Clear key and value
-        (*data)[index].key.clear();
-        (*data)[index].value = ValueType{};
+        stats.recordRemove();
+        eraseElement(index);
 
         return true;
     }
 
-    std::tuple<bool, ValueType> get(const KeyType &key)
+    std::tuple<bool, ValueType> get(KeyViewType key)
     {
+        return get(key, hashKey(key));
+    }
+
+    std::tuple<bool, ValueType> get(KeyViewType key, size_t keyHash)
+    {
+        recordAccess(keyHash);
+        expire();
         // Get coorect index from probing
-        uint32_t index = getIndexFromProbing(key);
+        uint32_t index = getIndexFromProbing(key, keyHash);
+        stats.recordLookup(index != Size);
         if (index == Size)
         {
             // Key not found
@@ -99,51 +242,590 @@ public:
         }
 
         // Update LRU linked list since this element was just accessed
-        unlinkElement(index);
-        linkElement(index);
+        touchElement(index);
 
         return std::make_tuple(true, (*data)[index].value);
     }
 
+    // Same as calling get() for every key in order, results[i] is the result for keys[i]. The keys are hashed
+    // and their home slots prefetched PrefetchDistance keys ahead of the one being probed, so the cache misses of
+    // consecutive lookups overlap instead of each one waiting for the previous.
+    void get_batch(const std::vector<KeyBatchType> &keys, std::vector<std::tuple<bool, ValueType>> &results)
+    {
+        results.resize(keys.size());
+        processBatch(keys, false, [this, &keys, &results](size_t i, size_t keyHash) {
+            results[i] = get(keys[i], keyHash);
+        });
+    }
+
+    // Same as calling insert() for every key and value in order with prefetching like get_batch. Returns the
+    // number of keys inserted or updated, an insert can only fail if the table is full.
+    uint32_t insert_batch(const std::vector<KeyBatchType> &keys, const std::vector<ValueType> &values)
+    {
+        uint32_t inserted = 0;
+        processBatch(keys, true, [this, &keys, &values, &inserted](size_t i, size_t keyHash) {
+            if (i < values.size() && upsert(keys[i], values[i], keyHash))
+            {
+                ++inserted;
+            }
+        });
+        return inserted;
+    }
+
+    // Get the value of a key without changing the LRU/MRU order in any recency policy. An element whose TTL has
+    // passed is not found but only removed by the next operation that is not const.
+    std::tuple<bool, ValueType> peek(KeyViewType key) const
+    {
+        uint32_t index = getIndexFromProbing(key, hashKey(key));
+        if (index != Size && isExpired(&(*data)[index], getTimeIfExpiring()))
+        {
+            index = Size;
+        }
+        stats.recordLookup(index != Size);
+        if (index == Size)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+        return std::make_tuple(true, (*data)[index].value);
+    }
+
+    // Fold every element of other into this table, walking other from its least to its most recently used
+    // element. A key that exists in both tables gets combine(thisValue, otherValue) and a new key gets the value
+    // from other. Merged elements become the most recently used in the order they had in other, so merging the
+    // tables of consecutive parts of an input in order gives the same LRU/MRU order as one table built from the
+    // whole input. Returns false if a new key did not fit in this table. Merging a table into itself changes
+    // nothing and returns false. Elements of other whose TTL has passed are skipped, and an element of other with
+    // a TTL keeps the time it has left, replacing the TTL of the key in this table like insert with a TTL does.
+    template<typename Combine>
+    bool merge(const HashTable &other, Combine combine)
+    {
+        if (&other == this)
+        {
+            // Touching the elements would reorder the list being walked
+            return false;
+        }
+        expire();
+        const uint64_t otherNow = other.getTimeIfExpiring();
+        bool allMerged = true;
+        for (HashElementPtr element = other.lastElement.leftElement; element != &other.firstElement;
+             element = element->leftElement)
+        {
+            if (other.isExpired(element, otherNow))
+            {
+                continue;
+            }
+            bool found = false;
+            const uint32_t index = getSlotForInsert(element->key, hashKey(element->key), element->value, found);
+            if (index == Size)
+            {
+                stats.recordRejected();
+                allMerged = false;
+                continue;
+            }
+            if (found)
+            {
+                (*data)[index].value = combine((*data)[index].value, element->value);
+                touchElement(index);
+                allMerged = (!weigh || chargeWeight(index)) && allMerged;
+                mergeTtl(index, other, element, otherNow);
+                continue;
+            }
+            stats.recordInsert((*data)[index].erased);
+            (*data)[index].key = element->key;
+            (*data)[index].value = element->value;
+            (*data)[index].erased = false;
+            (*data)[index].referenced = false;
+            linkElement(index);
+            allMerged = chargeWeight(index) && allMerged;
+            mergeTtl(index, other, element, otherNow);
+        }
+        return allMerged;
+    }
+
+    // The k elements with the largest values by compare, largest first. Elements with equal values are ordered
+    // by slot. The slot array is scanned once keeping the best k elements seen so far in a heap whose top is the
+    // worst of them, so this takes O(n log k) instead of sorting every element, and only the k results are
+    // copied. The LRU/MRU order is not changed. Like peek, elements whose TTL has passed are skipped.
+    template<typename Compare = std::less<ValueType>>
+    std::vector<KeyValuePair> top_k_by_value(size_t k, Compare compare = Compare{}) const
+    {
+        // a ranks before b, with the lower slot first for equal values
+        const auto ranksBefore = [&compare](const HashElement *a, const HashElement *b) {
+            if (compare(b->value, a->value))
+            {
+                return true;
+            }
+            return !compare(a->value, b->value) && a < b;
+        };
+
+        if (k == 0)
+        {
+            return {};
+        }
+        const uint64_t now = getTimeIfExpiring();
+        std::vector<const HashElement *> best;
+        best.reserve(k < Size ? k : Size);
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            if (!isOccupied(index) || isExpired(&(*data)[index], now))
+            {
+                continue;
+            }
+            const HashElement *element = &(*data)[index];
+            if (best.size() < k)
+            {
+                best.push_back(element);
+                std::push_heap(best.begin(), best.end(), ranksBefore);
+            }
+            else if (ranksBefore(element, best.front()))
+            {
+                // Replace the worst of the best k
+                std::pop_heap(best.begin(), best.end(), ranksBefore);
+                best.back() = element;
+                std::push_heap(best.begin(), best.end(), ranksBefore);
+            }
+        }
+        std::sort_heap(best.begin(), best.end(), ranksBefore);
+
+        std::vector<KeyValuePair> result;
+        result.reserve(best.size());
+        for (const HashElement *element : best)
+        {
+            result.emplace_back(element->key, element->value);
+        }
+        return result;
+    }
+
+    // With the Clock recency policy hits do not move elements, so this is the most recently inserted element or
+    // the element that most recently got a second chance. Like peek, elements whose TTL has passed are skipped.
     std::tuple<bool, KeyValuePair> get_last() const
     {
-        if (firstElement.rightElement == &lastElement)
+        const uint64_t now = getTimeIfExpiring();
+        HashElementPtr element = firstElement.rightElement;
+        while (element != &lastElement && isExpired(element, now))
+        {
+            element = element->rightElement;
+        }
+        if (element == &lastElement)
         {
             // Table is empty
             return std::make_tuple(false, KeyValuePair{});
         }
-        auto keyValuePair = std::make_tuple(firstElement.rightElement->key, firstElement.rightElement->value);
+        auto keyValuePair = std::make_tuple(element->key, element->value);
         return std::make_tuple(true, keyValuePair);
     }
 
+    // With the Clock recency policy the least recently used element is the one that would be evicted next, the
+    // first element from the end of the list without its reference bit set. Finding it walks past every
+    // referenced element at the end of the list without clearing their bits, so with Clock this is O(n) when most
+    // elements are referenced, while eviction clears the bits it passes and stays O(1) amortized. With Exact it is
+    // O(1). Like peek, elements whose TTL has passed are skipped.
     std::tuple<bool, KeyValuePair> get_first() const
     {
-        if (lastElement.leftElement == &firstElement)
+        const uint64_t now = getTimeIfExpiring();
+        // Least recently used element that has not expired
+        HashElementPtr leastRecent = nullptr;
+        for (HashElementPtr element = lastElement.leftElement; element != &firstElement;
+             element = element->leftElement)
+        {
+            if (isExpired(element, now))
+            {
+                continue;
+            }
+            if (leastRecent == nullptr)
+            {
+                leastRecent = element;
+            }
+            if (options.recencyPolicy != RecencyPolicy::Clock || !element->referenced)
+            {
+                return std::make_tuple(true, std::make_tuple(element->key, element->value));
+            }
+        }
+        if (leastRecent == nullptr)
         {
             // Table is empty
             return std::make_tuple(false, KeyValuePair{});
         }
-        auto keyValuePair = std::make_tuple(lastElement.leftElement->key, lastElement.leftElement->value);
-        return std::make_tuple(true, keyValuePair);
+        // Every element is referenced, after clearing all bits the end of the list is evicted
+        return std::make_tuple(true, std::make_tuple(leastRecent->key, leastRecent->value));
     }
 
-    uint32_t getHash(const KeyType &key) const
+    // Full hash of a key
+    size_t hashKey(KeyViewType key) const
     {
-        std::hash<KeyType> hasher;
-        return hasher(key) % Size;
+        return hasher(key);
+    }
+
+    uint32_t getHash(KeyViewType key) const
+    {
+        return getIndexFromHash(hashKey(key));
+    }
+
+    // Hash of a default constructed key, stored in snapshots to detect a hasher that changed between runs
+    static uint64_t hasherCheck()
+    {
+        return Hasher{}(KeyType{});
+    }
+
+    // Remove every element without calling the eviction callback
+    void clear()
+    {
+        for (HashElement &element : *data)
+        {
+            element = HashElement{};
+        }
+        firstElement.rightElement = &lastElement;
+        lastElement.leftElement = &firstElement;
+        usedByteCount = 0;
+        stats.resetOccupancy(0, 0);
+        if (ttlWheel)
+        {
+            ttlWheel->clear();
+        }
+    }
+
+    // Sum of the weights of the elements, kept up to date by every insert and removal
+    uint64_t usedBytes() const
+    {
+        return usedByteCount;
+    }
+
+    // Pages the slot array got, weaker than options.pagePolicy if the system could not provide them
+    PagePolicy pagePolicy() const
+    {
+        return data.get_deleter().policy;
+    }
+
+    // Counters of the Stats policy, with HashTableStats call toText() or toJson() on the result to dump them
+    const Stats &statistics() const
+    {
+        return stats;
+    }
+
+    // Write the table to a snapshot file, see hash_table_snapshot.h for the layout. Every slot is written at its
+    // own index together with the LRU/MRU links, so the order survives a save and load. The file is written
+    // through a stream in chunks of slots instead of being built in memory. Returns false on a write error.
+    // Snapshots do not store TTLs: elements whose TTL has passed are written as erased slots and left out of the
+    // order, and the other elements are loaded back without a TTL.
+    bool save(const std::string &path) const
+    {
+        using SlotType = snapshot::Slot<ValueType>;
+        using Codec = snapshot::KeyCodec<KeyType>;
+        static_assert(std::is_trivially_copyable<ValueType>::value, "Snapshot values are stored as raw bytes");
+        static constexpr uint32_t ChunkSlots = 4096;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        snapshot::Header header{};
+        // Written again at the end once the element count and key pool size are known
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        const uint64_t now = getTimeIfExpiring();
+        std::vector<SlotType> chunk(ChunkSlots);
+        uint64_t keyPoolSize = 0;
+        uint32_t elementCount = 0;
+        for (uint32_t chunkStart = 0; chunkStart < Size; chunkStart += ChunkSlots)
+        {
+            const uint32_t chunkSize = Size - chunkStart < ChunkSlots ? Size - chunkStart : ChunkSlots;
+            // Clear the padding bytes as well so the file content only depends on the table
+            std::memset(static_cast<void *>(chunk.data()), 0, sizeof(SlotType) * chunkSize);
+            for (uint32_t i = 0; i < chunkSize; ++i)
+            {
+                const uint32_t index = chunkStart + i;
+                SlotType &slot = chunk[i];
+                slot.moreRecent = snapshot::NoSlot;
+                slot.lessRecent = snapshot::NoSlot;
+                if (!isOccupied(index) || isExpired(&(*data)[index], now))
+                {
+                    // An expired element still holds its place in probing chains like an erased slot
+                    slot.state = (*data)[index].erased || isOccupied(index) ? snapshot::SlotState::Erased
+                                                                            : snapshot::SlotState::Unused;
+                    continue;
+                }
+                const HashElement &element = (*data)[index];
+                slot.state = snapshot::SlotState::Occupied;
+                slot.referenced = element.referenced ? 1 : 0;
+                slot.value = element.value;
+                slot.keyOffset = keyPoolSize;
+                slot.keyLength = static_cast<uint32_t>(Codec::encode(element.key).size());
+                slot.moreRecent = getSnapshotIndex(skipExpired(element.leftElement, false, now));
+                slot.lessRecent = getSnapshotIndex(skipExpired(element.rightElement, true, now));
+                keyPoolSize += slot.keyLength;
+                ++elementCount;
+            }
+            file.write(reinterpret_cast<const char *>(chunk.data()), sizeof(SlotType) * chunkSize);
+        }
+
+        // Keys in the same slot order the offsets were given in
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            if (isOccupied(index) && !isExpired(&(*data)[index], now))
+            {
+                const std::string_view keyBytes = Codec::encode((*data)[index].key);
+                file.write(keyBytes.data(), static_cast<std::streamsize>(keyBytes.size()));
+            }
+        }
+
+        std::memcpy(header.magic, snapshot::Magic, sizeof(snapshot::Magic));
+        header.version = snapshot::Version;
+        header.slotCount = Size;
+        header.elementCount = elementCount;
+        header.valueSize = sizeof(ValueType);
+        header.mostRecentSlot = getSnapshotIndex(skipExpired(firstElement.rightElement, true, now));
+        header.leastRecentSlot = getSnapshotIndex(skipExpired(lastElement.leftElement, false, now));
+        header.hasherCheck = hasherCheck();
+        header.keyPoolOffset = sizeof(snapshot::Header) + static_cast<uint64_t>(Size) * sizeof(SlotType);
+        header.keyPoolSize = keyPoolSize;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.flush();
+        return static_cast<bool>(file);
+    }
+
+    // Replace the content of the table with a snapshot file written by save. If the snapshot has the same Size
+    // and hasher every slot is copied to the same index and the links are restored without hashing or probing
+    // any key. Otherwise the elements are inserted again from the least to the most recently used one, which
+    // gives the same LRU/MRU order. Returns false and leaves the table empty if the file cannot be read or is
+    // damaged, or if the elements do not fit and the table rejects new keys when full.
+    bool load(const std::string &path)
+    {
+        const HashTableSnapshot<HashTable> snapshotFile(path);
+        clear();
+        if (!snapshotFile.hasValidOrder())
+        {
+            return false;
+        }
+
+        const snapshot::Header &header = snapshotFile.header();
+        if (!snapshotFile.matchesLayout())
+        {
+            uint32_t index = header.leastRecentSlot;
+            while (index != snapshot::NoSlot)
+            {
+                const auto &slot = snapshotFile.slot(index);
+                ValueType *value = find_or_insert(snapshotFile.keyOf(slot));
+                if (value == nullptr)
+                {
+                    clear();
+                    return false;
+                }
+                *value = slot.value;
+                index = slot.moreRecent;
+            }
+            return true;
+        }
+
+        // Every occupied slot must be on the LRU/MRU list, which hasValidOrder checked, and have its key inside the
+        // key pool before any key is decoded
+        uint32_t elementCount = 0;
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            const auto &slot = snapshotFile.slot(index);
+            if (slot.state == snapshot::SlotState::Occupied)
+            {
+                if (!snapshotFile.hasValidKey(slot))
+                {
+                    return false;
+                }
+                ++elementCount;
+            }
+        }
+        if (elementCount != header.elementCount)
+        {
+            // An occupied slot is not on the LRU/MRU list
+            return false;
+        }
+
+        uint32_t erasedCount = 0;
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            const auto &slot = snapshotFile.slot(index);
+            HashElement &element = (*data)[index];
+            if (slot.state == snapshot::SlotState::Erased)
+            {
+                element.erased = true;
+                ++erasedCount;
+            }
+            else if (slot.state == snapshot::SlotState::Occupied)
+            {
+                element.key = KeyType(snapshotFile.keyOf(slot));
+                element.value = slot.value;
+                element.referenced = slot.referenced != 0;
+                element.leftElement = getElementFromSnapshot(slot.moreRecent, &firstElement);
+                element.rightElement = getElementFromSnapshot(slot.lessRecent, &lastElement);
+                element.weight = getWeight(element);
+                usedByteCount += element.weight;
+            }
+        }
+        firstElement.rightElement = getElementFromSnapshot(header.mostRecentSlot, &lastElement);
+        lastElement.leftElement = getElementFromSnapshot(header.leastRecentSlot, &firstElement);
+        stats.resetOccupancy(elementCount, erasedCount);
+        if (options.byteBudget != 0)
+        {
+            // The snapshot may have been written with a larger budget
+            enforceByteBudget(Size);
+        }
+        return true;
     }
 
 private:
+    template<typename Table>
+    friend class HashTableSnapshot;
+
     struct HashElement
     {
         HashElement *rightElement = nullptr;
         HashElement *leftElement = nullptr;
         ValueType value{};
+        // Bytes counted in usedBytes, 0 for unused and erased slots
+        uint32_t weight = 0;
         KeyType key{};
         bool erased = false;
+        // Set on access with the Clock recency policy
+        bool referenced = false;
     };
     using HashElementPtr = HashElement *;
 
+public:
+    // Iterator over the double linked list that only reads it, so walking the elements does not change their
+    // order or reference bits. MostRecentFirst walks from get_last() to the end of the list, otherwise from the
+    // end of the list to get_last(). Inserting or removing elements invalidates only iterators to them. Dereferencing
+    // returns a pair of references by value, so it is an input iterator. Like peek, elements whose TTL had passed
+    // when the range was created are skipped.
+    template<bool MostRecentFirst>
+    class RecencyIterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<const KeyType &, const ValueType &>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        RecencyIterator(const HashElement *element, const HashTable *table, uint64_t now)
+            : element(element), table(table), now(now)
+        {
+            skipExpired();
+        }
+
+        reference operator*() const
+        {
+            return reference(element->key, element->value);
+        }
+
+        RecencyIterator &operator++()
+        {
+            element = MostRecentFirst ? element->rightElement : element->leftElement;
+            skipExpired();
+            return *this;
+        }
+
+        RecencyIterator operator++(int)
+        {
+            RecencyIterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const RecencyIterator &other) const
+        {
+            return element == other.element;
+        }
+
+        bool operator!=(const RecencyIterator &other) const
+        {
+            return element != other.element;
+        }
+
+    private:
+        void skipExpired()
+        {
+            while (table->isExpired(element, now))
+            {
+                element = MostRecentFirst ? element->rightElement : element->leftElement;
+            }
+        }
+
+        const HashElement *element;
+        const HashTable *table;
+        uint64_t now;
+    };
+
+    template<bool MostRecentFirst>
+    class RecencyRange
+    {
+    public:
+        RecencyRange(const HashElement *first, const HashElement *end, const HashTable *table)
+            : first(first), last(end), table(table), now(table->getTimeIfExpiring())
+        {
+        }
+
+        RecencyIterator<MostRecentFirst> begin() const
+        {
+            return RecencyIterator<MostRecentFirst>(first, table, now);
+        }
+
+        RecencyIterator<MostRecentFirst> end() const
+        {
+            return RecencyIterator<MostRecentFirst>(last, table, now);
+        }
+
+    private:
+        const HashElement *first;
+        const HashElement *last;
+        const HashTable *table;
+        uint64_t now;
+    };
+
+    // Elements from the most to the least recently used, for (const auto &[key, value] : table.mru_order())
+    RecencyRange<true> mru_order() const
+    {
+        return RecencyRange<true>(firstElement.rightElement, &lastElement, this);
+    }
+
+    // Elements from the least to the most recently used
+    RecencyRange<false> lru_order() const
+    {
+        return RecencyRange<false>(lastElement.leftElement, &firstElement, this);
+    }
+
+private:
+    // Frees a slot array from allocateSlots, mappedBytes is 0 if it came from operator new
+    struct SlotArrayDeleter
+    {
+        size_t mappedBytes = 0;
+        PagePolicy policy = PagePolicy::Default;
+
+        void operator()(std::array<HashElement, Size> *slots) const
+        {
+            if (mappedBytes == 0)
+            {
+                delete slots;
+                return;
+            }
+            slots->~array();
+            page_allocation::release(slots, mappedBytes);
+        }
+    };
+    using SlotArray = std::unique_ptr<std::array<HashElement, Size>, SlotArrayDeleter>;
+
+    // Map the slot array with the page policy of the options, or allocate it with operator new when the options
+    // ask for nothing special or mapping failed
+    static SlotArray allocateSlots(const HashTableOptions &options)
+    {
+        if (options.pagePolicy != PagePolicy::Default || options.prefault)
+        {
+            const page_allocation::Allocation allocation =
+                page_allocation::allocate(sizeof(std::array<HashElement, Size>), options.pagePolicy, options.prefault);
+            if (allocation.memory != nullptr)
+            {
+                return SlotArray(new (allocation.memory) std::array<HashElement, Size>(),
+                                 SlotArrayDeleter{allocation.mappedBytes, allocation.policy});
+            }
+        }
+        return SlotArray(new std::array<HashElement, Size>());
+    }
+
     // Since we use first and last elements in the double linked list to avoid edge cases,
     // an element is occupied if both left and right pointers are not null
     bool isOccupied(const uint32_t index) const
@@ -151,36 +833,432 @@ private:
         return (*data)[index].rightElement != nullptr && (*data)[index].leftElement != nullptr;
     }
 
-    bool keysMatch(const KeyType &key1, const KeyType &key2) const
+    // Hash every key and prefetch its home slot PrefetchDistance keys before calling process for it
+    template<typename Process>
+    void processBatch(const std::vector<KeyBatchType> &keys, bool forWrite, Process process)
+    {
+        std::array<size_t, PrefetchDistance> hashes{};
+        const size_t count = keys.size();
+        const size_t ahead = count < PrefetchDistance ? count : PrefetchDistance;
+        for (size_t i = 0; i < ahead; ++i)
+        {
+            hashes[i] = hashKey(keys[i]);
+            prefetchSlot(hashes[i], forWrite);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t keyHash = hashes[i % PrefetchDistance];
+            // Start loading the slot of a later key before probing this one
+            const size_t next = i + PrefetchDistance;
+            if (next < count)
+            {
+                hashes[next % PrefetchDistance] = hashKey(keys[next]);
+                prefetchSlot(hashes[next % PrefetchDistance], forWrite);
+            }
+            process(i, keyHash);
+        }
+    }
+
+    void prefetchSlot(size_t keyHash, bool forWrite) const
+    {
+        const HashElement *element = &(*data)[getIndexFromHash(keyHash)];
+        if (forWrite)
+        {
+            __builtin_prefetch(element, 1);
+        }
+        else
+        {
+            __builtin_prefetch(element, 0);
+        }
+    }
+
+    static uint32_t getIndexFromHash(size_t keyHash)
+    {
+        if constexpr (IsPowerOfTwo)
+        {
+            return static_cast<uint32_t>(keyHash) & (Size - 1);
+        }
+        return static_cast<uint32_t>(keyHash % Size);
+    }
+
+    // Linear probing without a modulo
+    static uint32_t getNextIndex(uint32_t index)
+    {
+        if constexpr (IsPowerOfTwo)
+        {
+            return (index + ProbingFactor) & (Size - 1);
+        }
+        return index + ProbingFactor == Size ? 0 : index + ProbingFactor;
+    }
+
+    bool keysMatch(const KeyType &key1, KeyViewType key2) const
     {
         return key1 == key2;
     }
 
-    uint32_t getIndexFromProbing(const KeyType &key) const
+    uint32_t getIndexFromProbing(KeyViewType key, size_t keyHash) const
     {
-        uint32_t index = getHash(key);
+        uint32_t index = getIndexFromHash(keyHash);
         const uint32_t startIndex = index;
-        // First check if the exists in the hash table
-        // If the node we hit from this hash is not occupied or not erased then this key deos not exist in the
-        // table
-        if (!isOccupied(index) && !(*data)[index].erased)
+        uint32_t probeLength = 1;
+        // Erased slots do not break the probing chain, only a slot that was never used ends it
+        while (isOccupied(index) || (*data)[index].erased)
         {
-            return Size; // Indicate not found
+            if (isOccupied(index) && keysMatch((*data)[index].key, key))
+            {
+                stats.recordProbe(probeLength);
+                return index;
+            }
+            // Linear probing
+            index = getNextIndex(index);
+            if (index == startIndex)
+            {
+                // We have looped through the entire table
+                break;
+            }
+            ++probeLength;
         }
-        // If the key at this index does not match the key we are looking for, we need to probe linearly
-        while (!keysMatch((*data)[index].key, key))
+        stats.recordProbe(probeLength);
+        return Size; // Indicate not found
+    }
+
+    // Walk the probing chain of the key once. If the key exists its slot is returned and found is set.
+    // Otherwise the first erased slot of the chain is returned, or the unused slot the chain ends at, or the
+    // slot of the evicted element if the table is full and in eviction mode. Size means the table is full or the
+    // new key with value is heavier than the whole byte budget, which is checked before anything is evicted.
+    uint32_t getSlotForInsert(KeyViewType key, size_t keyHash, const ValueType &value, bool &found)
+    {
+        found = false;
+        uint32_t index = getIndexFromHash(keyHash);
+        const uint32_t startIndex = index;
+        uint32_t firstErasedIndex = Size;
+        uint32_t freeIndex = Size;
+        uint32_t probeLength = 0;
+        do
         {
-            // Linear probing
-            index = (index + ProbingFactor) % Size;
-            if (index == startIndex || (!isOccupied(index) && !(*data)[index].erased))
+            ++probeLength;
+            if (isOccupied(index))
+            {
+                if (keysMatch((*data)[index].key, key))
+                {
+                    stats.recordProbe(probeLength);
+                    found = true;
+                    return index;
+                }
+            }
+            else if ((*data)[index].erased)
+            {
+                // Remember the first erased slot but keep walking since the key may exist after it
+                if (firstErasedIndex == Size)
+                {
+                    firstErasedIndex = index;
+                }
+            }
+            else
             {
-                // We have looped through the entire table or hit an unoccupied slot so key does not exist
-                return Size; // Indicate not found
+                // Unused slot, the key does not exist
+                freeIndex = firstErasedIndex != Size ? firstErasedIndex : index;
+                break;
             }
+            // Linear probing
+            index = getNextIndex(index);
+        } while (index != startIndex);
+        stats.recordProbe(probeLength);
+
+        if (exceedsByteBudget(key, value))
+        {
+            return Size;
+        }
+        if (freeIndex != Size || firstErasedIndex != Size)
+        {
+            return freeIndex != Size ? freeIndex : firstErasedIndex;
+        }
+
+        // Table full
+        if (options.capacityPolicy != CapacityPolicy::EvictLeastRecentlyUsed)
+        {
+            return Size;
+        }
+        // Every slot is occupied so any slot is on the probing chain of the new key and the evicted slot can be
+        // reused in place without breaking other chains
+        const uint32_t victimIndex = selectVictim();
+        if (sketch && sketch->estimate(keyHash) <= sketch->estimate(hashKey((*data)[victimIndex].key)))
+        {
+            // The new key is not used more often than the element it would evict
+            return Size;
+        }
+        evictElement(victimIndex, false);
+        return victimIndex;
+    }
+
+    // Find the slot of the key or insert the key with value, Size if the key cannot be inserted
+    uint32_t findOrInsertIndex(KeyViewType key, size_t keyHash, const ValueType &value = ValueType{})
+    {
+        recordAccess(keyHash);
+        expire();
+        bool found = false;
+        const uint32_t index = getSlotForInsert(key, keyHash, value, found);
+        if (index == Size)
+        {
+            stats.recordRejected();
+            return Size;
+        }
+
+        if (found)
+        {
+            touchElement(index);
+            return index;
         }
+
+        stats.recordInsert((*data)[index].erased);
+        (*data)[index].key = key;
+        (*data)[index].value = value;
+        // If previously erased, reset erased flag
+        (*data)[index].erased = false;
+        (*data)[index].referenced = false;
+
+        // Link this element to the beginning of the list
+        linkElement(index);
+        chargeWeight(index);
         return index;
     }
 
+    // Unlink an element and leave an erased slot
+    void eraseElement(uint32_t index)
+    {
+        // Unlink element from double linked list
+        unlinkElement(index);
+        if (ttlWheel)
+        {
+            ttlWheel->cancel(index);
+        }
+
+        // Set erased as true in order to not break probing chains
+        (*data)[index].erased = true;
+        (*data)[index].referenced = false;
+
+        // Clear key and value
+        (*data)[index].key = KeyType{};
+        (*data)[index].value = ValueType{};
+        usedByteCount -= (*data)[index].weight;
+        (*data)[index].weight = 0;
+    }
+
+    void expireElement(uint32_t index)
+    {
+        stats.recordExpiration();
+        eraseElement(index);
+    }
+
+    uint64_t getTime() const
+    {
+        if (options.ttlClock)
+        {
+            return options.ttlClock();
+        }
+        const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(sinceEpoch).count());
+    }
+
+    // Current time if any element has a TTL, 0 otherwise so tables without TTLs never read the clock
+    uint64_t getTimeIfExpiring() const
+    {
+        return ttlWheel ? getTime() : 0;
+    }
+
+    // Whether the TTL of an element has passed at now but the element was not removed yet. The first and last
+    // elements of the list never expire.
+    bool isExpired(const HashElement *element, uint64_t now) const
+    {
+        if (!ttlWheel || element == &firstElement || element == &lastElement)
+        {
+            return false;
+        }
+        const auto index = static_cast<uint32_t>(element - &(*data)[0]);
+        return ttlWheel->isScheduled(index) && ttlWheel->expiry(index) <= now;
+    }
+
+    // First element from element towards the less or more recently used end of the list that has not expired
+    const HashElement *skipExpired(const HashElement *element, bool towardsLessRecent, uint64_t now) const
+    {
+        while (isExpired(element, now))
+        {
+            element = towardsLessRecent ? element->rightElement : element->leftElement;
+        }
+        return element;
+    }
+
+    // Give the element at index the time the element of other has left until it expires, if it has a TTL
+    void mergeTtl(uint32_t index, const HashTable &other, const HashElement *element, uint64_t otherNow)
+    {
+        if (!other.ttlWheel || !isOccupied(index))
+        {
+            // No TTL in other, or the element was evicted by the byte budget
+            return;
+        }
+        const auto otherIndex = static_cast<uint32_t>(element - &(*other.data)[0]);
+        if (!other.ttlWheel->isScheduled(otherIndex))
+        {
+            return;
+        }
+        TimingWheel &wheel = getTimingWheel();
+        wheel.schedule(index, wheel.now() + (other.ttlWheel->expiry(otherIndex) - otherNow));
+    }
+
+    // The timing wheel is only allocated when the first TTL is set
+    TimingWheel &getTimingWheel()
+    {
+        if (!ttlWheel)
+        {
+            ttlWheel = std::make_unique<TimingWheel>(Size, getTime());
+        }
+        return *ttlWheel;
+    }
+
+    // Count an access for the frequency filter
+    void recordAccess(size_t keyHash)
+    {
+        if (sketch)
+        {
+            sketch->increment(keyHash);
+        }
+    }
+
+    // Slot index of a list neighbour in a snapshot, the first and last elements become NoSlot
+    uint32_t getSnapshotIndex(const HashElement *element) const
+    {
+        if (element == &firstElement || element == &lastElement)
+        {
+            return snapshot::NoSlot;
+        }
+        return static_cast<uint32_t>(element - &(*data)[0]);
+    }
+
+    HashElementPtr getElementFromSnapshot(uint32_t index, HashElementPtr end)
+    {
+        return index == snapshot::NoSlot ? end : &(*data)[index];
+    }
+
+    // Record an access of an element according to the recency policy
+    void touchElement(uint32_t index)
+    {
+        if (options.recencyPolicy == RecencyPolicy::Clock)
+        {
+            // Only write if the bit is not set yet so repeated hits leave the cache line clean
+            if (!(*data)[index].referenced)
+            {
+                (*data)[index].referenced = true;
+            }
+            return;
+        }
+        stats.recordRelink();
+        unlinkElement(index);
+        linkElement(index);
+    }
+
+    // Slot index of the least recently used element, the element get_first returns. With the Clock recency
+    // policy the referenced elements at the end of the list get their second chance first.
+    uint32_t selectVictim()
+    {
+        if (options.recencyPolicy == RecencyPolicy::Clock)
+        {
+            // Second chance, referenced elements at the end of the list are moved to the beginning
+            while (lastElement.leftElement->referenced)
+            {
+                const uint32_t referencedIndex = static_cast<uint32_t>(lastElement.leftElement - &(*data)[0]);
+                (*data)[referencedIndex].referenced = false;
+                stats.recordRelink();
+                unlinkElement(referencedIndex);
+                linkElement(referencedIndex);
+            }
+        }
+        return static_cast<uint32_t>(lastElement.leftElement - &(*data)[0]);
+    }
+
+    // Unlink an element so its slot is ready to be overwritten by a new key, or leave an erased slot
+    void evictElement(uint32_t index, bool leaveErased)
+    {
+        if (onEviction)
+        {
+            onEviction((*data)[index].key, (*data)[index].value);
+        }
+        stats.recordEviction(leaveErased);
+        if (leaveErased)
+        {
+            eraseElement(index);
+            return;
+        }
+        unlinkElement(index);
+        if (ttlWheel)
+        {
+            ttlWheel->cancel(index);
+        }
+        usedByteCount -= (*data)[index].weight;
+        (*data)[index].weight = 0;
+    }
+
+    uint32_t getWeight(KeyViewType key, const ValueType &value) const
+    {
+        if (weigh)
+        {
+            return weigh(key, value);
+        }
+        return static_cast<uint32_t>(snapshot::KeyCodec<KeyType>::encode(key).size() + sizeof(ValueType));
+    }
+
+    uint32_t getWeight(const HashElement &element) const
+    {
+        return getWeight(element.key, element.value);
+    }
+
+    // Whether a new key with value alone is heavier than the byte budget, it is rejected then without being
+    // inserted or evicting anything
+    bool exceedsByteBudget(KeyViewType key, const ValueType &value) const
+    {
+        return options.byteBudget != 0 && getWeight(key, value) > options.byteBudget;
+    }
+
+    // Weigh an element again after its key or value changed and keep the table within the byte budget. Returns
+    // false if an existing element got a value that alone is heavier than the budget, it is evicted then instead
+    // of every other element. New keys that heavy are rejected by getSlotForInsert before they are inserted.
+    bool chargeWeight(uint32_t index)
+    {
+        HashElement &element = (*data)[index];
+        const uint32_t weight = getWeight(element);
+        usedByteCount = usedByteCount - element.weight + weight;
+        element.weight = weight;
+        if (options.byteBudget == 0 || usedByteCount <= options.byteBudget)
+        {
+            return true;
+        }
+        if (weight > options.byteBudget)
+        {
+            evictElement(index, true);
+            return false;
+        }
+        enforceByteBudget(index);
+        return true;
+    }
+
+    // Evict from the least recently used end until the weights fit in the byte budget, never the element at
+    // keepIndex, Size for none
+    void enforceByteBudget(uint32_t keepIndex)
+    {
+        while (usedByteCount > options.byteBudget && firstElement.rightElement != &lastElement)
+        {
+            const uint32_t victimIndex = selectVictim();
+            if (victimIndex == keepIndex)
+            {
+                // With the Clock policy the kept element can be at the end of the list, move it out of the way
+                stats.recordRelink();
+                unlinkElement(keepIndex);
+                linkElement(keepIndex);
+                continue;
+            }
+            evictElement(victimIndex, true);
+        }
+    }
+
     void linkElement(uint32_t index)
     {
         // Link this element to the beginning of the list
@@ -212,13 +1290,26 @@ private:
         (*data)[index].rightElement = nullptr;
     }
 
+    HashTableOptions options;
+    EvictionCallback onEviction;
+    WeightFunction weigh;
+    // Sum of the weights of the occupied slots
+    uint64_t usedByteCount = 0;
+    Hasher hasher;
+    // Updated by const lookups as well, with HashTableStats concurrent const lookups are not safe
+    mutable Stats stats;
+    // Only allocated with the FrequencyFilter admission policy
+    std::unique_ptr<FrequencySketch> sketch;
+    // Expiry of the elements with a TTL, allocated by the first insert with a TTL
+    std::unique_ptr<TimingWheel> ttlWheel;
+
     // Use if first and last elements to avoid edges cases
     HashElement firstElement{};
     HashElement lastElement{};
 
     // Hash table data storage as a contiguous array for better cache locality
     // Add this to the heap so to not exceed stack size for large tables
-    std::unique_ptr<std::array<HashElement, Size>> data;
+    SlotArray data;
 };
 
 #endif // HASH_TABLE_H
@@ -0,0 +1,295 @@
+#ifndef HASH_TABLE_SIMD_H
+#define HASH_TABLE_SIMD_H
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include <immintrin.h>
+
+// Hash Table with LRU/MRU ordering that probes using a separate array of 1 byte control values and SIMD.
+// It has the same interface and the same double linked list as HashTable<Size>.
+//
+// How probing works:
+// 1. Every slot has a control byte stored in an array next to the slot array. An empty slot is 0x80, an
+// erased slot is 0xFE and an occupied slot stores the lowest 7 bits of the hash of its key (a tag).
+//
+// 2. The hash is split in two. The upper bits choose the group of control bytes we start probing from and
+// the lowest 7 bits are the tag. A group is 32 control bytes with AVX2 or 16 control bytes with SSE2.
+//
+// 3. A whole group is compared against the tag with a single instruction and the result is turned into a
+// bit mask. Keys are only compared for the slots whose tag matched, so probing mostly touches the small
+// control array instead of the elements with their strings.
+//
+// 4. If the group has an empty control byte the key does not exist, otherwise we probe the next group.
+// When removing, a slot can become empty again only if its group already has an empty slot, because then
+// no probing chain has ever continued past this group. Otherwise it is marked as erased.
+template<uint32_t Size>
+class HashTableSIMD
+{
+public:
+    using KeyType = std::string;
+    using ValueType = uint32_t;
+    using KeyValuePair = std::tuple<KeyType, ValueType>;
+
+#ifdef __AVX2__
+    static constexpr uint32_t GroupWidth = 32;
+#else
+    static constexpr uint32_t GroupWidth = 16;
+#endif
+    static constexpr uint32_t GroupCount = (Size + GroupWidth - 1) / GroupWidth;
+
+    HashTableSIMD()
+        : data(std::make_unique<std::array<HashElement, Size>>()),
+          control(std::make_unique<std::array<int8_t, GroupCount * GroupWidth>>())
+    {
+        firstElement.rightElement = &lastElement;
+        firstElement.leftElement = nullptr;
+        lastElement.rightElement = nullptr;
+        lastElement.leftElement = &firstElement;
+
+        // The control bytes after the last slot pad the last group and must never match or be free
+        for (uint32_t i = 0; i < GroupCount * GroupWidth; ++i)
+        {
+            (*control)[i] = i < Size ? Empty : Sentinel;
+        }
+    }
+    ~HashTableSIMD() = default;
+    HashTableSIMD(const HashTableSIMD &other) = delete;
+    HashTableSIMD(HashTableSIMD &&other) = delete;
+    HashTableSIMD &operator=(const HashTableSIMD &other) = delete;
+    HashTableSIMD &operator=(HashTableSIMD &&other) = delete;
+
+    bool insert(const KeyType &key, const ValueType &value)
+    {
+        const size_t hash = getHash(key);
+        uint32_t index = getIndexFromProbing(key, hash);
+        if (index == Size)
+        {
+            // New key, take the first empty or erased slot on its probing chain
+            index = getFreeIndex(hash);
+            if (index == Size)
+            {
+                // Table full
+                return false;
+            }
+            (*control)[index] = getTag(hash);
+            (*data)[index].key = key;
+        }
+        else
+        {
+            unlinkElement(index);
+        }
+        (*data)[index].value = value;
+
+        // Link this element to the beginning of the list
+        linkElement(index);
+
+        return true;
+    }
+
+    bool remove(const KeyType &key)
+    {
+        const uint32_t index = getIndexFromProbing(key, getHash(key));
+        if (index == Size)
+        {
+            // Key not found
+            return false;
+        }
+
+        // Unlink element from double linked list
+        unlinkElement(index);
+
+        // The slot becomes empty only if no probing chain can go through its group
+        const uint32_t groupStart = index - index % GroupWidth;
+        (*control)[index] = matchEmpty(groupStart) != 0 ? Empty : Erased;
+
+        // Clear key and value
+        (*data)[index].key.clear();
+        (*data)[index].value = ValueType{};
+
+        return true;
+    }
+
+    std::tuple<bool, ValueType> get(const KeyType &key)
+    {
+        const uint32_t index = getIndexFromProbing(key, getHash(key));
+        if (index == Size)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+
+        // Update LRU linked list since this element was just accessed
+        unlinkElement(index);
+        linkElement(index);
+
+        return std::make_tuple(true, (*data)[index].value);
+    }
+
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        if (firstElement.rightElement == &lastElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(firstElement.rightElement->key, firstElement.rightElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        if (lastElement.leftElement == &firstElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(lastElement.leftElement->key, lastElement.leftElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    size_t getHash(const KeyType &key) const
+    {
+        std::hash<KeyType> hasher;
+        return hasher(key);
+    }
+
+private:
+    // Control byte values, a tag is always in [0, 127]
+    static constexpr int8_t Empty = -128;
+    static constexpr int8_t Erased = -2;
+    static constexpr int8_t Sentinel = -1;
+
+    struct HashElement
+    {
+        HashElement *rightElement = nullptr;
+        HashElement *leftElement = nullptr;
+        ValueType value{};
+        KeyType key{};
+    };
+    using HashElementPtr = HashElement *;
+
+    static int8_t getTag(size_t hash)
+    {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    static uint32_t getStartGroup(size_t hash)
+    {
+        return static_cast<uint32_t>((hash >> 7) % GroupCount);
+    }
+
+    // Compare all control bytes of the group starting at groupStart with value and return one bit per match
+    uint32_t matchByte(uint32_t groupStart, int8_t value) const
+    {
+#ifdef __AVX2__
+        const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(control->data() + groupStart));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, _mm256_set1_epi8(value))));
+#else
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control->data() + groupStart));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#endif
+    }
+
+    uint32_t matchEmpty(uint32_t groupStart) const
+    {
+        return matchByte(groupStart, Empty);
+    }
+
+    // Empty and erased are the only control values below the sentinel
+    uint32_t matchEmptyOrErased(uint32_t groupStart) const
+    {
+#ifdef __AVX2__
+        const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(control->data() + groupStart));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(Sentinel), group)));
+#else
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control->data() + groupStart));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(Sentinel), group)));
+#endif
+    }
+
+    uint32_t getIndexFromProbing(const KeyType &key, size_t hash) const
+    {
+        const int8_t tag = getTag(hash);
+        uint32_t group = getStartGroup(hash);
+        for (uint32_t probed = 0; probed < GroupCount; ++probed)
+        {
+            const uint32_t groupStart = group * GroupWidth;
+            uint32_t tagMask = matchByte(groupStart, tag);
+            while (tagMask != 0)
+            {
+                // Only compare keys where the tag matched
+                const uint32_t index = groupStart + __builtin_ctz(tagMask);
+                if ((*data)[index].key == key)
+                {
+                    return index;
+                }
+                // clear least significant 1 bit
+                tagMask &= tagMask - 1;
+            }
+            if (matchEmpty(groupStart) != 0)
+            {
+                // The chain ends at this group so key does not exist
+                return Size;
+            }
+            // Probe the next group linearly
+            group = group + 1 == GroupCount ? 0 : group + 1;
+        }
+        return Size; // Indicate not found
+    }
+
+    uint32_t getFreeIndex(size_t hash) const
+    {
+        uint32_t group = getStartGroup(hash);
+        for (uint32_t probed = 0; probed < GroupCount; ++probed)
+        {
+            const uint32_t groupStart = group * GroupWidth;
+            const uint32_t freeMask = matchEmptyOrErased(groupStart);
+            if (freeMask != 0)
+            {
+                return groupStart + __builtin_ctz(freeMask);
+            }
+            group = group + 1 == GroupCount ? 0 : group + 1;
+        }
+        return Size; // Table full
+    }
+
+    void linkElement(uint32_t index)
+    {
+        // Link this element to the beginning of the list
+        // Left to right connection
+        HashElementPtr temp = firstElement.rightElement;
+        firstElement.rightElement = &(*data)[index];
+        (*data)[index].rightElement = temp;
+
+        // Right to left connection
+        temp->leftElement = &(*data)[index];
+        (*data)[index].leftElement = &firstElement;
+    }
+
+    void unlinkElement(uint32_t index)
+    {
+        // Unlink the element from the double linked list
+        (*data)[index].leftElement->rightElement = (*data)[index].rightElement;
+        (*data)[index].rightElement->leftElement = (*data)[index].leftElement;
+
+        (*data)[index].leftElement = nullptr;
+        (*data)[index].rightElement = nullptr;
+    }
+
+    // Use if first and last elements to avoid edges cases
+    HashElement firstElement{};
+    HashElement lastElement{};
+
+    // Elements and their control bytes are stored in separate contiguous arrays on the heap, the control array
+    // is padded to a whole number of groups
+    std::unique_ptr<std::array<HashElement, Size>> data;
+    std::unique_ptr<std::array<int8_t, GroupCount * GroupWidth>> control;
+};
+
+#endif // HASH_TABLE_SIMD_H
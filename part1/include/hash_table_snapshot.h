@@ -0,0 +1,291 @@
+#ifndef HASH_TABLE_SNAPSHOT_H
+#define HASH_TABLE_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "mapped_file.h"
+
+// Flat file layout HashTable::save writes and HashTable::load and HashTableSnapshot read.
+//
+// How the layout works:
+// 1. A 64 byte header with a magic value, the format version, the number of slots and elements, the size of
+// the value type, the slots of the most and least recently used elements and the offset of the key pool.
+//
+// 2. One fixed size record per slot of the table at the same index the slot has in memory: its state, the
+// value, the offset and length of its key in the key pool and the slot indices of the next more and less
+// recently used elements. Since the slots keep their index, a snapshot written by a table with the same Size
+// and hasher can be probed in place and copied back without hashing any key.
+//
+// 3. The key pool, the bytes of every key one after the other. Strings are stored as their characters and
+// trivially copyable keys as their object representation.
+//
+// Numbers are stored in the byte order of the machine, a snapshot is meant to be read back on the same
+// architecture by a build with the same Key and Value types.
+namespace snapshot
+{
+constexpr char Magic[8] = {'H', 'T', 'S', 'N', 'A', 'P', '0', '1'};
+constexpr uint32_t Version = 1;
+// Slot index of the end of the LRU/MRU list
+constexpr uint32_t NoSlot = UINT32_MAX;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t elementCount;
+    uint32_t valueSize;
+    uint32_t mostRecentSlot;
+    uint32_t leastRecentSlot;
+    // Hash of a default constructed key, a different value means the hasher changed and slots must be rehashed
+    uint64_t hasherCheck;
+    uint64_t keyPoolOffset;
+    uint64_t keyPoolSize;
+    uint8_t reserved[8];
+};
+static_assert(sizeof(Header) == 64, "Snapshot header must keep its size");
+
+enum class SlotState : uint8_t
+{
+    Unused,
+    Occupied,
+    Erased,
+};
+
+template<typename Value>
+struct Slot
+{
+    uint64_t keyOffset;
+    uint32_t keyLength;
+    uint32_t moreRecent;
+    uint32_t lessRecent;
+    SlotState state;
+    uint8_t referenced;
+    Value value;
+};
+
+// How keys are stored in the key pool
+template<typename Key>
+struct KeyCodec
+{
+    static_assert(std::is_trivially_copyable<Key>::value, "Snapshot keys must be strings or trivially copyable");
+
+    static std::string_view encode(const Key &key)
+    {
+        return std::string_view(reinterpret_cast<const char *>(&key), sizeof(Key));
+    }
+
+    static Key decode(const char *bytes, uint32_t length)
+    {
+        Key key{};
+        std::memcpy(&key, bytes, length);
+        return key;
+    }
+
+    static bool isValidLength(uint32_t length)
+    {
+        return length == sizeof(Key);
+    }
+};
+
+template<>
+struct KeyCodec<std::string>
+{
+    static std::string_view encode(std::string_view key)
+    {
+        return key;
+    }
+
+    static std::string_view decode(const char *bytes, uint32_t length)
+    {
+        return std::string_view(bytes, length);
+    }
+
+    static bool isValidLength(uint32_t /*length*/)
+    {
+        return true;
+    }
+};
+} // namespace snapshot
+
+// Read only view of a snapshot file written by HashTable::save. The file is memory mapped, so opening it only
+// reads the header and a lookup only touches the pages of the slots it probes and of the key it compares. This
+// serves lookups right after a restart while HashTable::load, or nothing at all, rebuilds the table.
+//
+// Lookups need the snapshot to have the slot layout of Table (matchesLayout), otherwise get returns not found.
+// Nothing in the file is changed, so lookups do not update the recorded LRU/MRU order.
+template<typename Table>
+class HashTableSnapshot
+{
+public:
+    using KeyType = typename Table::KeyType;
+    using KeyViewType = typename Table::KeyViewType;
+    using ValueType = typename Table::ValueType;
+    using KeyValuePair = typename Table::KeyValuePair;
+    using SlotType = snapshot::Slot<ValueType>;
+    using Codec = snapshot::KeyCodec<KeyType>;
+    static_assert(std::is_trivially_copyable<ValueType>::value, "Snapshot values are stored as raw bytes");
+
+    explicit HashTableSnapshot(const std::string &path) : file(path, AccessPattern::Random)
+    {
+        const std::string_view contents = file.contents();
+        if (contents.size() < sizeof(snapshot::Header))
+        {
+            return;
+        }
+        fileHeader = reinterpret_cast<const snapshot::Header *>(contents.data());
+        const uint64_t slotsSize = static_cast<uint64_t>(fileHeader->slotCount) * sizeof(SlotType);
+        const bool valid = std::memcmp(fileHeader->magic, snapshot::Magic, sizeof(snapshot::Magic)) == 0 &&
+                           fileHeader->version == snapshot::Version && fileHeader->valueSize == sizeof(ValueType) &&
+                           fileHeader->keyPoolOffset == sizeof(snapshot::Header) + slotsSize &&
+                           fileHeader->keyPoolOffset + fileHeader->keyPoolSize <= contents.size() &&
+                           fileHeader->elementCount <= fileHeader->slotCount &&
+                           isSlotOrEnd(fileHeader->mostRecentSlot) && isSlotOrEnd(fileHeader->leastRecentSlot);
+        if (!valid)
+        {
+            fileHeader = nullptr;
+            return;
+        }
+        slots = reinterpret_cast<const SlotType *>(contents.data() + sizeof(snapshot::Header));
+        keyPool = contents.data() + fileHeader->keyPoolOffset;
+    }
+    ~HashTableSnapshot() = default;
+    HashTableSnapshot(const HashTableSnapshot &other) = delete;
+    HashTableSnapshot(HashTableSnapshot &&other) = delete;
+    HashTableSnapshot &operator=(const HashTableSnapshot &other) = delete;
+    HashTableSnapshot &operator=(HashTableSnapshot &&other) = delete;
+
+    // The file exists and has a valid header for the key and value types of Table
+    bool isOpen() const
+    {
+        return fileHeader != nullptr;
+    }
+
+    // The snapshot was written by a table with the same Size and hasher, so keys are in the slots Table would
+    // probe for them
+    bool matchesLayout() const
+    {
+        return isOpen() && fileHeader->slotCount == Table::SlotCount && fileHeader->hasherCheck == Table::hasherCheck();
+    }
+
+    uint32_t size() const
+    {
+        return isOpen() ? fileHeader->elementCount : 0;
+    }
+
+    std::tuple<bool, ValueType> get(KeyViewType key) const
+    {
+        if (!matchesLayout())
+        {
+            return std::make_tuple(false, ValueType{});
+        }
+        uint32_t index = Table::getIndexFromHash(hasher(key));
+        const uint32_t startIndex = index;
+        // Same probing as HashTable, erased slots do not break the chain
+        while (slots[index].state != snapshot::SlotState::Unused)
+        {
+            const SlotType &slot = slots[index];
+            if (slot.state == snapshot::SlotState::Occupied && hasValidKey(slot) && keyOf(slot) == key)
+            {
+                return std::make_tuple(true, slot.value);
+            }
+            index = Table::getNextIndex(index);
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        return std::make_tuple(false, ValueType{});
+    }
+
+    // Most recently used element when the snapshot was written
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        return getElement(isOpen() ? fileHeader->mostRecentSlot : snapshot::NoSlot);
+    }
+
+    // Least recently used element when the snapshot was written
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        return getElement(isOpen() ? fileHeader->leastRecentSlot : snapshot::NoSlot);
+    }
+
+    // Raw access used by HashTable::load, only valid if isOpen()
+    const snapshot::Header &header() const
+    {
+        return *fileHeader;
+    }
+
+    const SlotType &slot(uint32_t index) const
+    {
+        return slots[index];
+    }
+
+    // The key lies inside the key pool and has a valid length for KeyType
+    bool hasValidKey(const SlotType &slot) const
+    {
+        return slot.keyOffset <= fileHeader->keyPoolSize && slot.keyLength <= fileHeader->keyPoolSize - slot.keyOffset &&
+               Codec::isValidLength(slot.keyLength);
+    }
+
+    // A view into the mapped key pool for strings, or a copy of the key for trivially copyable keys
+    auto keyOf(const SlotType &slot) const
+    {
+        return Codec::decode(keyPool + slot.keyOffset, slot.keyLength);
+    }
+
+    // Walk the LRU/MRU list from the most recently used element and check that it is a single chain through
+    // elementCount occupied slots with consistent links in both directions, so a damaged file cannot create a
+    // cycle or point outside the slot array
+    bool hasValidOrder() const
+    {
+        if (!isOpen())
+        {
+            return false;
+        }
+        uint32_t previous = snapshot::NoSlot;
+        uint32_t index = fileHeader->mostRecentSlot;
+        for (uint32_t visited = 0; visited < fileHeader->elementCount; ++visited)
+        {
+            if (index == snapshot::NoSlot || slots[index].state != snapshot::SlotState::Occupied ||
+                slots[index].moreRecent != previous || !hasValidKey(slots[index]) ||
+                !isSlotOrEnd(slots[index].lessRecent))
+            {
+                return false;
+            }
+            previous = index;
+            index = slots[index].lessRecent;
+        }
+        return index == snapshot::NoSlot && previous == fileHeader->leastRecentSlot;
+    }
+
+private:
+    bool isSlotOrEnd(uint32_t index) const
+    {
+        return index == snapshot::NoSlot || index < fileHeader->slotCount;
+    }
+
+    std::tuple<bool, KeyValuePair> getElement(uint32_t index) const
+    {
+        if (index == snapshot::NoSlot || !hasValidKey(slots[index]))
+        {
+            // Snapshot is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(KeyType(keyOf(slots[index])), slots[index].value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    MappedFile file;
+    typename Table::HasherType hasher;
+    const snapshot::Header *fileHeader = nullptr;
+    const SlotType *slots = nullptr;
+    const char *keyPool = nullptr;
+};
+
+#endif // HASH_TABLE_SNAPSHOT_H
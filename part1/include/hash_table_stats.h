@@ -0,0 +1,198 @@
+#ifndef HASH_TABLE_STATS_H
+#define HASH_TABLE_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Statistics policies of HashTable, the Stats template parameter. HashTable calls the record functions at every
+// probe, hit, miss, insert, remove, expiration, relink and eviction.
+//
+// NoHashTableStats is the default. Its functions are empty and inline, so the calls and the probe counting
+// around them are removed by the compiler and an uninstrumented table runs the same code as before.
+//
+// HashTableStats counts the events and can be written out as text or JSON to tune the table size against real
+// traffic. The counters are plain integers that const lookups such as peek() update as well, so with
+// HashTableStats concurrent const readers of a table race on the counters and need the same locking as writers.
+struct NoHashTableStats
+{
+    void setCapacity(uint32_t /*capacity*/) {}
+    void recordProbe(uint32_t /*length*/) {}
+    void recordLookup(bool /*hit*/) {}
+    void recordInsert(bool /*reusedTombstone*/) {}
+    void recordRejected() {}
+    void recordRemove() {}
+    void recordExpiration() {}
+    void recordRelink() {}
+    void recordEviction(bool /*leavesTombstone*/) {}
+    void resetOccupancy(uint32_t /*occupied*/, uint32_t /*tombstones*/) {}
+};
+
+struct HashTableStats
+{
+    // Probe lengths from 1 to HistogramSize - 1 slots have their own bucket, longer probes share the last one
+    static constexpr uint32_t HistogramSize = 32;
+
+    uint32_t capacity = 0;
+    // Slots holding a key and erased slots (tombstones) right now
+    uint32_t occupied = 0;
+    uint32_t tombstones = 0;
+
+    // Lookups by get and peek that found or did not find the key
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // New keys, new keys that took an erased slot and new keys rejected because the table was full
+    uint64_t inserts = 0;
+    uint64_t tombstoneReuses = 0;
+    uint64_t rejected = 0;
+    uint64_t removes = 0;
+    // Elements removed because their TTL passed
+    uint64_t expirations = 0;
+    // Moves of an element to the beginning of the double linked list on access or second chance
+    uint64_t relinks = 0;
+    uint64_t evictions = 0;
+
+    // Number of probing chain walks and how many slots they looked at
+    uint64_t probes = 0;
+    uint64_t probedSlots = 0;
+    std::array<uint64_t, HistogramSize> probeLengths{};
+
+    void setCapacity(uint32_t tableCapacity)
+    {
+        capacity = tableCapacity;
+    }
+
+    void recordProbe(uint32_t length)
+    {
+        ++probes;
+        probedSlots += length;
+        ++probeLengths[length < HistogramSize ? length : HistogramSize - 1];
+    }
+
+    void recordLookup(bool hit)
+    {
+        if (hit)
+        {
+            ++hits;
+        }
+        else
+        {
+            ++misses;
+        }
+    }
+
+    void recordInsert(bool reusedTombstone)
+    {
+        ++inserts;
+        ++occupied;
+        if (reusedTombstone)
+        {
+            ++tombstoneReuses;
+            --tombstones;
+        }
+    }
+
+    void recordRejected()
+    {
+        ++rejected;
+    }
+
+    void recordRemove()
+    {
+        ++removes;
+        --occupied;
+        ++tombstones;
+    }
+
+    void recordExpiration()
+    {
+        ++expirations;
+        --occupied;
+        ++tombstones;
+    }
+
+    void recordRelink()
+    {
+        ++relinks;
+    }
+
+    // The slot of an element evicted for a new key is reused by that key, which records an insert. An element
+    // evicted for the byte budget leaves an erased slot.
+    void recordEviction(bool leavesTombstone)
+    {
+        ++evictions;
+        --occupied;
+        if (leavesTombstone)
+        {
+            ++tombstones;
+        }
+    }
+
+    // Called when the whole content of the table is replaced, by clear or load
+    void resetOccupancy(uint32_t occupiedSlots, uint32_t tombstoneSlots)
+    {
+        occupied = occupiedSlots;
+        tombstones = tombstoneSlots;
+    }
+
+    double loadFactor() const
+    {
+        return capacity == 0 ? 0.0 : static_cast<double>(occupied) / capacity;
+    }
+
+    double meanProbeLength() const
+    {
+        return probes == 0 ? 0.0 : static_cast<double>(probedSlots) / static_cast<double>(probes);
+    }
+
+    std::string toText() const
+    {
+        std::ostringstream out;
+        out << "capacity: " << capacity << "\n"
+            << "occupied: " << occupied << "\n"
+            << "tombstones: " << tombstones << "\n"
+            << "load factor: " << loadFactor() << "\n"
+            << "hits: " << hits << "\n"
+            << "misses: " << misses << "\n"
+            << "inserts: " << inserts << "\n"
+            << "tombstone reuses: " << tombstoneReuses << "\n"
+            << "rejected: " << rejected << "\n"
+            << "removes: " << removes << "\n"
+            << "expirations: " << expirations << "\n"
+            << "relinks: " << relinks << "\n"
+            << "evictions: " << evictions << "\n"
+            << "probes: " << probes << "\n"
+            << "mean probe length: " << meanProbeLength() << "\n"
+            << "probe lengths:\n";
+        for (uint32_t length = 1; length < HistogramSize; ++length)
+        {
+            if (probeLengths[length] != 0)
+            {
+                out << "  " << length << (length == HistogramSize - 1 ? "+" : "") << ": " << probeLengths[length]
+                    << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    // probe_lengths[i] is the number of probes that looked at i slots, the last entry counts longer probes too
+    std::string toJson() const
+    {
+        std::ostringstream out;
+        out << "{\"capacity\":" << capacity << ",\"occupied\":" << occupied << ",\"tombstones\":" << tombstones
+            << ",\"load_factor\":" << loadFactor() << ",\"hits\":" << hits << ",\"misses\":" << misses
+            << ",\"inserts\":" << inserts << ",\"tombstone_reuses\":" << tombstoneReuses
+            << ",\"rejected\":" << rejected << ",\"removes\":" << removes << ",\"expirations\":" << expirations
+            << ",\"relinks\":" << relinks << ",\"evictions\":" << evictions << ",\"probes\":" << probes
+            << ",\"mean_probe_length\":" << meanProbeLength() << ",\"probe_lengths\":[";
+        for (uint32_t length = 0; length < HistogramSize; ++length)
+        {
+            out << (length == 0 ? "" : ",") << probeLengths[length];
+        }
+        out << "]}";
+        return out.str();
+    }
+};
+
+#endif // HASH_TABLE_STATS_H
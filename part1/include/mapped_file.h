@@ -0,0 +1,43 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// How the mapped file is going to be read, passed to the kernel so it can choose how far to read ahead
+enum class AccessPattern
+{
+    Sequential,
+    Random,
+};
+
+// Read only memory map of a whole file, so a text can be tokenized or a snapshot read without copying the file
+// into a buffer first
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path, AccessPattern accessPattern = AccessPattern::Sequential);
+    ~MappedFile();
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile(MappedFile &&other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+    MappedFile &operator=(MappedFile &&other) = delete;
+
+    bool isOpen() const
+    {
+        return opened;
+    }
+
+    std::string_view contents() const
+    {
+        return std::string_view(data, size);
+    }
+
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,41 @@
+#ifndef PAGE_ALLOCATION_H
+#define PAGE_ALLOCATION_H
+
+#include <cstddef>
+
+// Pages backing the slot array of a large table. Random probes over tens of millions of slots miss the TLB on
+// nearly every access with 4 KiB pages, one 2 MiB page covers 512 times as many slots per TLB entry.
+enum class PagePolicy
+{
+    // Normal pages, from operator new unless the slot array is prefaulted
+    Default,
+    // Anonymous memory aligned to 2 MiB and marked with madvise(MADV_HUGEPAGE), the kernel backs it with huge
+    // pages when it has them and with normal pages otherwise
+    TransparentHugePages,
+    // Anonymous memory from the reserved huge pages of the system (MAP_HUGETLB, see
+    // /proc/sys/vm/nr_hugepages). Falls back to TransparentHugePages when none are free.
+    ExplicitHugePages,
+};
+
+namespace page_allocation
+{
+constexpr size_t HugePageSize = size_t{2} << 20;
+
+struct Allocation
+{
+    // Zero filled memory aligned to at least a page, nullptr if nothing could be mapped
+    void *memory = nullptr;
+    size_t mappedBytes = 0;
+    // Policy that was applied after falling back, Default if memory is nullptr
+    PagePolicy policy = PagePolicy::Default;
+};
+
+// Map at least bytes of anonymous memory with the pages of policy, falling back to the next weaker policy when a
+// policy cannot be applied and to normal pages for less than a huge page. With prefault every page is faulted
+// in before returning, so the first accesses by live traffic do not fault.
+Allocation allocate(size_t bytes, PagePolicy policy, bool prefault);
+
+void release(void *memory, size_t mappedBytes);
+} // namespace page_allocation
+
+#endif // PAGE_ALLOCATION_H
@@ -0,0 +1,97 @@
+#ifndef PARALLEL_WORD_COUNT_H
+#define PARALLEL_WORD_COUNT_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "word_tokenizer.h"
+
+// Count the words of a text into a Hash Table using several threads (map-reduce).
+//
+// How counting works:
+// 1. The text is split in threadCount parts of about the same size. Every split point is moved forward to the
+// next whitespace character so no word is cut in two.
+//
+// 2. Every thread tokenizes its part and counts the words in its own table, so threads share nothing while
+// counting.
+//
+// 3. The tables are merged into result in the order of the parts. Since merge() keeps the LRU/MRU order of the
+// merged table, the counts and the final LRU/MRU order are the same as counting the whole text on one thread,
+// no matter how the threads were scheduled.
+//
+// Returns false if a word did not fit in one of the tables. The total number of words is written to wordCount
+// if it is not null.
+template<typename Table>
+bool countWordsParallel(std::string_view text, uint32_t threadCount, Table &result, size_t *wordCount = nullptr)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    // Split points, part i is [splits[i], splits[i + 1])
+    std::vector<size_t> splits(threadCount + 1, text.size());
+    splits[0] = 0;
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        size_t split = text.size() / threadCount * i;
+        if (split < splits[i - 1])
+        {
+            split = splits[i - 1];
+        }
+        while (split < text.size() && !WordTokenizer::isWhitespace(text[split]))
+        {
+            ++split;
+        }
+        splits[i] = split;
+    }
+
+    std::vector<std::unique_ptr<Table>> tables;
+    std::vector<char> partFits(threadCount, 1);
+    std::vector<size_t> partWords(threadCount, 0);
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        tables.push_back(std::make_unique<Table>());
+    }
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back([&, i]() {
+            Table &table = *tables[i];
+            const std::string_view part = text.substr(splits[i], splits[i + 1] - splits[i]);
+            partWords[i] = WordTokenizer::tokenize(part, [&table, &partFits, i](std::string_view word) {
+                auto *count = table.find_or_insert(word);
+                if (count == nullptr)
+                {
+                    partFits[i] = 0;
+                    return;
+                }
+                ++(*count);
+            });
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    bool allCounted = true;
+    size_t totalWords = 0;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        totalWords += partWords[i];
+        using ValueType = typename Table::ValueType;
+        allCounted = result.merge(*tables[i], [](const ValueType &a, const ValueType &b) { return a + b; }) &&
+                     partFits[i] != 0 && allCounted;
+    }
+    if (wordCount != nullptr)
+    {
+        *wordCount = totalWords;
+    }
+    return allCounted;
+}
+
+#endif // PARALLEL_WORD_COUNT_H
@@ -0,0 +1,346 @@
+#ifndef ROBIN_HOOD_HASH_TABLE_H
+#define ROBIN_HOOD_HASH_TABLE_H
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// By default probing chains are limited to 256 slots, or to the whole table if it is smaller
+constexpr uint32_t defaultMaxDisplacement(uint32_t size)
+{
+    return size <= 256 ? size - 1 : 255;
+}
+
+// Hash Table with LRU/MRU ordering that uses Robin Hood linear probing with backward shift deletion.
+// It has the same interface and the same double linked list as HashTable<Size>, but it never leaves erased
+// slots (tombstones) behind, so lookups do not get slower after many removes.
+//
+// How probing works:
+// 1. Every element stores its displacement, the distance from the slot its hash points to (home slot).
+//
+// 2. Inserting walks from the home slot and stops at the first slot whose element has a smaller
+// displacement than the distance walked so far (a "richer" element). The elements from there up to the next
+// empty slot are shifted right by one and the new element takes the slot. This keeps the elements of a
+// probing chain ordered by home slot and the displacements balanced.
+//
+// 3. Because of this order a lookup can stop as soon as it meets an element with a smaller displacement than
+// the distance walked, or when the distance is above the current maximum displacement of the table.
+//
+// 4. Removing shifts the following elements of the chain left by one until an empty slot or an element in
+// its home slot, so no tombstone is needed.
+//
+// 5. No element is allowed a displacement above MaxDisplacement. An insert that would need it fails like an
+// insert into a full table, so the worst case probing length is bounded.
+//
+// Moved elements take over the position of the old slot in the double linked list, so the LRU/MRU order is
+// not affected by the shifting.
+template<uint32_t Size, uint32_t MaxDisplacement = defaultMaxDisplacement(Size)>
+class RobinHoodHashTable
+{
+public:
+    using KeyType = std::string;
+    using ValueType = uint32_t;
+    using KeyValuePair = std::tuple<KeyType, ValueType>;
+    static_assert(MaxDisplacement < Size, "Displacement must be smaller than the table size");
+
+    RobinHoodHashTable()
+        : data(std::make_unique<std::array<HashElement, Size>>()),
+          displacementCounts(std::make_unique<std::array<uint32_t, MaxDisplacement + 1>>())
+    {
+        firstElement.rightElement = &lastElement;
+        firstElement.leftElement = nullptr;
+        lastElement.rightElement = nullptr;
+        lastElement.leftElement = &firstElement;
+        displacementCounts->fill(0);
+    }
+    ~RobinHoodHashTable() = default;
+    RobinHoodHashTable(const RobinHoodHashTable &other) = delete;
+    RobinHoodHashTable(RobinHoodHashTable &&other) = delete;
+    RobinHoodHashTable &operator=(const RobinHoodHashTable &other) = delete;
+    RobinHoodHashTable &operator=(RobinHoodHashTable &&other) = delete;
+
+    bool insert(const KeyType &key, const ValueType &value)
+    {
+        const uint32_t homeIndex = getHash(key);
+        uint32_t index = getIndexFromProbing(key, homeIndex);
+        if (index != Size)
+        {
+            // Key exists, update value and move it to the beginning of the list
+            (*data)[index].value = value;
+            unlinkElement(index);
+            linkElement(index);
+            return true;
+        }
+        if (elementCount == Size)
+        {
+            // Table full
+            return false;
+        }
+
+        // Find the slot the new element belongs to, the first empty slot or the first richer element
+        index = homeIndex;
+        uint32_t displacement = 0;
+        while (isOccupied(index) && (*data)[index].displacement >= displacement)
+        {
+            index = nextIndex(index);
+            ++displacement;
+        }
+        if (displacement > MaxDisplacement)
+        {
+            return false;
+        }
+
+        // Find the end of the chain, every element until there is shifted right by one
+        uint32_t emptyIndex = index;
+        while (isOccupied(emptyIndex))
+        {
+            if ((*data)[emptyIndex].displacement + 1 > MaxDisplacement)
+            {
+                return false;
+            }
+            emptyIndex = nextIndex(emptyIndex);
+        }
+        while (emptyIndex != index)
+        {
+            const uint32_t sourceIndex = previousIndex(emptyIndex);
+            moveElement(sourceIndex, emptyIndex, (*data)[sourceIndex].displacement + 1);
+            emptyIndex = sourceIndex;
+        }
+
+        (*data)[index].key = key;
+        (*data)[index].value = value;
+        setDisplacement(index, displacement);
+        ++elementCount;
+        linkElement(index);
+
+        return true;
+    }
+
+    bool remove(const KeyType &key)
+    {
+        uint32_t index = getIndexFromProbing(key, getHash(key));
+        if (index == Size)
+        {
+            // Key not found
+            return false;
+        }
+
+        // Unlink element from double linked list and clear key and value
+        unlinkElement(index);
+        removeDisplacement((*data)[index].displacement);
+        (*data)[index].key.clear();
+        (*data)[index].value = ValueType{};
+        --elementCount;
+
+        // Backward shift the rest of the chain so there is no hole in it
+        uint32_t next = nextIndex(index);
+        while (isOccupied(next) && (*data)[next].displacement > 0)
+        {
+            moveElement(next, index, (*data)[next].displacement - 1);
+            index = next;
+            next = nextIndex(next);
+        }
+
+        // The maximum can only decrease on remove, drop it to the highest displacement still in use
+        while (maxDisplacement > 0 && (*displacementCounts)[maxDisplacement] == 0)
+        {
+            --maxDisplacement;
+        }
+
+        return true;
+    }
+
+    std::tuple<bool, ValueType> get(const KeyType &key)
+    {
+        const uint32_t index = getIndexFromProbing(key, getHash(key));
+        if (index == Size)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+
+        // Update LRU linked list since this element was just accessed
+        unlinkElement(index);
+        linkElement(index);
+
+        return std::make_tuple(true, (*data)[index].value);
+    }
+
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        if (firstElement.rightElement == &lastElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(firstElement.rightElement->key, firstElement.rightElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        if (lastElement.leftElement == &firstElement)
+        {
+            // Table is empty
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        auto keyValuePair = std::make_tuple(lastElement.leftElement->key, lastElement.leftElement->value);
+        return std::make_tuple(true, keyValuePair);
+    }
+
+    uint32_t getHash(const KeyType &key) const
+    {
+        std::hash<KeyType> hasher;
+        return hasher(key) % Size;
+    }
+
+    uint32_t size() const
+    {
+        return elementCount;
+    }
+
+    // Largest distance of any element from its home slot, a lookup never probes more than this plus one slots
+    uint32_t max_displacement() const
+    {
+        return maxDisplacement;
+    }
+
+    // Average distance of the elements from their home slot
+    double mean_displacement() const
+    {
+        if (elementCount == 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(displacementSum) / static_cast<double>(elementCount);
+    }
+
+private:
+    struct HashElement
+    {
+        HashElement *rightElement = nullptr;
+        HashElement *leftElement = nullptr;
+        ValueType value{};
+        KeyType key{};
+        uint32_t displacement = 0;
+    };
+    using HashElementPtr = HashElement *;
+
+    // Since we use first and last elements in the double linked list to avoid edge cases,
+    // an element is occupied if both left and right pointers are not null
+    bool isOccupied(const uint32_t index) const
+    {
+        return (*data)[index].rightElement != nullptr && (*data)[index].leftElement != nullptr;
+    }
+
+    static uint32_t nextIndex(uint32_t index)
+    {
+        return index + 1 == Size ? 0 : index + 1;
+    }
+
+    static uint32_t previousIndex(uint32_t index)
+    {
+        return index == 0 ? Size - 1 : index - 1;
+    }
+
+    uint32_t getIndexFromProbing(const KeyType &key, uint32_t homeIndex) const
+    {
+        uint32_t index = homeIndex;
+        for (uint32_t displacement = 0; displacement <= maxDisplacement; ++displacement)
+        {
+            // An empty slot or a richer element means the key would have been placed before this slot
+            if (!isOccupied(index) || (*data)[index].displacement < displacement)
+            {
+                return Size;
+            }
+            if ((*data)[index].key == key)
+            {
+                return index;
+            }
+            index = nextIndex(index);
+        }
+        return Size; // Indicate not found
+    }
+
+    void setDisplacement(uint32_t index, uint32_t displacement)
+    {
+        (*data)[index].displacement = displacement;
+        ++(*displacementCounts)[displacement];
+        displacementSum += displacement;
+        if (displacement > maxDisplacement)
+        {
+            maxDisplacement = displacement;
+        }
+    }
+
+    void removeDisplacement(uint32_t displacement)
+    {
+        --(*displacementCounts)[displacement];
+        displacementSum -= displacement;
+    }
+
+    // Move an occupied element into an unoccupied slot and give it its new displacement
+    void moveElement(uint32_t from, uint32_t to, uint32_t displacement)
+    {
+        HashElement &source = (*data)[from];
+        HashElement &target = (*data)[to];
+        target.key = std::move(source.key);
+        target.value = source.value;
+        removeDisplacement(source.displacement);
+        setDisplacement(to, displacement);
+
+        // Take over the position of the source element in the double linked list
+        target.leftElement = source.leftElement;
+        target.rightElement = source.rightElement;
+        target.leftElement->rightElement = &target;
+        target.rightElement->leftElement = &target;
+        source.leftElement = nullptr;
+        source.rightElement = nullptr;
+        source.key.clear();
+        source.value = ValueType{};
+    }
+
+    void linkElement(uint32_t index)
+    {
+        // Link this element to the beginning of the list
+        // Left to right connection
+        HashElementPtr temp = firstElement.rightElement;
+        firstElement.rightElement = &(*data)[index];
+        (*data)[index].rightElement = temp;
+
+        // Right to left connection
+        temp->leftElement = &(*data)[index];
+        (*data)[index].leftElement = &firstElement;
+    }
+
+    void unlinkElement(uint32_t index)
+    {
+        // Unlink the element from the double linked list
+        (*data)[index].leftElement->rightElement = (*data)[index].rightElement;
+        (*data)[index].rightElement->leftElement = (*data)[index].leftElement;
+
+        // Set null the links of the node to remove so to become unoccupied
+        (*data)[index].leftElement = nullptr;
+        (*data)[index].rightElement = nullptr;
+    }
+
+    // Use if first and last elements to avoid edges cases
+    HashElement firstElement{};
+    HashElement lastElement{};
+
+    // Hash table data storage as a contiguous array for better cache locality
+    std::unique_ptr<std::array<HashElement, Size>> data;
+
+    // Number of elements per displacement, used to keep the maximum displacement up to date on remove
+    std::unique_ptr<std::array<uint32_t, MaxDisplacement + 1>> displacementCounts;
+    uint64_t displacementSum = 0;
+    uint32_t maxDisplacement = 0;
+    uint32_t elementCount = 0;
+};
+
+#endif // ROBIN_HOOD_HASH_TABLE_H
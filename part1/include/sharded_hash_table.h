@@ -0,0 +1,154 @@
+#ifndef SHARDED_HASH_TABLE_H
+#define SHARDED_HASH_TABLE_H
+
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "hash_table.h"
+
+// Thread safe Hash Table with LRU/MRU ordering made of ShardCount independent HashTable<ShardSize> shards.
+// Every shard has its own mutex and its own double linked list, so threads that access keys of different
+// shards never wait for each other.
+//
+// How sharding works:
+// 1. The key is hashed once. The upper 32 bits of the hash choose the shard and the full hash is passed to the
+// shard, which maps its lower bits to a slot. Using different bits for the two keeps the keys of a
+// shard spread over all of its slots.
+//
+// 2. Every operation locks only the mutex of its shard. Each shard is allocated separately so the mutexes and
+// lists of different shards do not share cache lines.
+//
+// 3. The LRU/MRU order is exact inside a shard but there is no global order, keeping one would need a write
+// to shared memory on every access. get_first() and get_last() return the least and most recently used
+// element of one shard, visiting the non empty shards in turn on every call. With a uniform hash every shard
+// holds a random sample of the keys, so the result is one of the least (or most) recently used keys overall
+// but not necessarily the least (or most) recently used one.
+template<uint32_t ShardSize,
+         uint32_t ShardCount,
+         typename Key = std::string,
+         typename Value = uint32_t,
+         typename Hasher = DefaultHasher<Key>>
+class ShardedHashTable
+{
+public:
+    using Table = HashTable<ShardSize, Key, Value, Hasher>;
+    using KeyViewType = typename Table::KeyViewType;
+    using ValueType = typename Table::ValueType;
+    using KeyValuePair = typename Table::KeyValuePair;
+
+    explicit ShardedHashTable(const HashTableOptions &options = HashTableOptions{})
+    {
+        for (auto &shard : shards)
+        {
+            shard = std::make_unique<Shard>(options);
+        }
+    }
+    ~ShardedHashTable() = default;
+    ShardedHashTable(const ShardedHashTable &other) = delete;
+    ShardedHashTable(ShardedHashTable &&other) = delete;
+    ShardedHashTable &operator=(const ShardedHashTable &other) = delete;
+    ShardedHashTable &operator=(ShardedHashTable &&other) = delete;
+
+    bool insert(KeyViewType key, const ValueType &value)
+    {
+        return upsert(key, value);
+    }
+
+    bool upsert(KeyViewType key, const ValueType &value)
+    {
+        const size_t keyHash = shards[0]->table.hashKey(key);
+        Shard &shard = getShard(keyHash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.table.upsert(key, value, keyHash);
+    }
+
+    // Add delta to the value of the key, inserting it with a default value first if it does not exist.
+    // Returns false if the key is new and its shard is full.
+    bool add(KeyViewType key, const ValueType &delta)
+    {
+        const size_t keyHash = shards[0]->table.hashKey(key);
+        Shard &shard = getShard(keyHash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ValueType *value = shard.table.find_or_insert(key, keyHash);
+        if (value == nullptr)
+        {
+            return false;
+        }
+        *value += delta;
+        return true;
+    }
+
+    bool remove(KeyViewType key)
+    {
+        const size_t keyHash = shards[0]->table.hashKey(key);
+        Shard &shard = getShard(keyHash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.table.remove(key, keyHash);
+    }
+
+    std::tuple<bool, ValueType> get(KeyViewType key)
+    {
+        const size_t keyHash = shards[0]->table.hashKey(key);
+        Shard &shard = getShard(keyHash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.table.get(key, keyHash);
+    }
+
+    // Least recently used element of one shard, see the notes above
+    std::tuple<bool, KeyValuePair> get_first()
+    {
+        return getFromNextShard([](const Table &table) { return table.get_first(); });
+    }
+
+    // Most recently used element of one shard, see the notes above
+    std::tuple<bool, KeyValuePair> get_last()
+    {
+        return getFromNextShard([](const Table &table) { return table.get_last(); });
+    }
+
+private:
+    // Each shard is aligned to a cache line so that its mutex does not share one with another shard
+    struct alignas(64) Shard
+    {
+        explicit Shard(const HashTableOptions &options) : table(options) {}
+
+        std::mutex mutex;
+        Table table;
+    };
+
+    Shard &getShard(size_t keyHash)
+    {
+        return *shards[static_cast<uint32_t>(static_cast<uint64_t>(keyHash) >> 32) % ShardCount];
+    }
+
+    template<typename Getter>
+    std::tuple<bool, KeyValuePair> getFromNextShard(Getter getter)
+    {
+        const uint32_t start = nextShard.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < ShardCount; ++i)
+        {
+            Shard &shard = *shards[(start + i) % ShardCount];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto result = getter(shard.table);
+            if (std::get<0>(result))
+            {
+                return result;
+            }
+        }
+        // Every shard is empty
+        return std::make_tuple(false, KeyValuePair{});
+    }
+
+    std::array<std::unique_ptr<Shard>, ShardCount> shards;
+    // Shard get_first and get_last start from, so repeated calls do not always return from the same shard
+    std::atomic<uint32_t> nextShard{0};
+};
+
+#endif // SHARDED_HASH_TABLE_H
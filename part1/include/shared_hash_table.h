@@ -0,0 +1,572 @@
+#ifndef SHARED_HASH_TABLE_H
+#define SHARED_HASH_TABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "hash_functions.h"
+#include "shared_memory.h"
+
+// Hash Table with LRU/MRU ordering that lives entirely in a shared memory segment, so one writer process and
+// any number of reader processes on the same host use a single copy of the table.
+//
+// How sharing works:
+// 1. The segment holds a header, the slot array and a key arena, and nothing points outside of it. The links of
+// the double linked list are 32-bit slot indices, with the first and last elements of the list at indices Size
+// and Size + 1 as in CompactHashTable, and a slot stores the offset and length of its key in the arena. Every
+// process can map the segment at a different address.
+//
+// 2. Keys are hashed with hash_functions::hashBytes, which gives the same hash in every process, so a reader
+// probes the slots the writer chose.
+//
+// 3. The header has a sequence counter (a seqlock). The writer makes it odd before changing the segment and even
+// again after. A reader copies what it looks up and then checks that the counter was even and did not change,
+// otherwise it reads again. Readers never write to the segment, so they map it read only and do not slow down
+// each other or the writer.
+//
+// 4. Removed keys leave a hole in the arena. When a new key does not fit at the end of the arena the writer
+// moves the keys still in use to its beginning.
+//
+// There must be only one writer at a time, nothing checks it. A reader's get does not change the LRU/MRU order,
+// only the writer's get does.
+//
+// If the writer dies while the counter is odd, readers give up after MaxStalledReads reads that see the same odd
+// counter and report the key as not found, and size() returns 0. A writer that attaches to such a segment
+// repairs it before making the counter even again: it rebuilds the list and the counts from the occupied slots,
+// so the LRU/MRU order is lost, and a key that was being moved when the writer died may no longer be found.
+template<uint32_t Size, typename Value = uint32_t>
+class SharedHashTable
+{
+public:
+    using KeyType = std::string;
+    using KeyViewType = std::string_view;
+    using ValueType = Value;
+    using KeyValuePair = std::tuple<KeyType, ValueType>;
+    static constexpr uint32_t ProbingFactor = 1;
+    // Arena size for keys of 32 bytes on average
+    static constexpr uint64_t DefaultArenaSize = uint64_t{32} * Size;
+    static_assert(std::is_trivially_copyable<ValueType>::value, "Shared values are stored as raw bytes");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The sequence counter must be lock free to be shared");
+    // Reads that may see the same odd counter before a reader assumes the writer died
+    static constexpr uint32_t MaxStalledReads = 1 << 16;
+
+    // Writer of a new table in the shared memory object name, replacing an existing one
+    explicit SharedHashTable(const std::string &name, uint64_t arenaSize = DefaultArenaSize)
+        : segment(name, getSegmentSize(arenaSize))
+    {
+        initialize(arenaSize);
+    }
+    // Reader, or writer after a restart, of the table in the shared memory object name
+    SharedHashTable(const std::string &name, SegmentAccess access) : segment(name, access)
+    {
+        attach();
+    }
+    // Writer of a new table in a file descriptor, for example from memfd_create, passed to readers by fork or
+    // over a Unix socket
+    SharedHashTable(int fd, uint64_t arenaSize) : segment(fd, getSegmentSize(arenaSize))
+    {
+        initialize(arenaSize);
+    }
+    // Reader, or writer after a restart, of the table in a file descriptor
+    SharedHashTable(int fd, SegmentAccess access) : segment(fd, access)
+    {
+        attach();
+    }
+    ~SharedHashTable() = default;
+    SharedHashTable(const SharedHashTable &other) = delete;
+    SharedHashTable(SharedHashTable &&other) = delete;
+    SharedHashTable &operator=(const SharedHashTable &other) = delete;
+    SharedHashTable &operator=(SharedHashTable &&other) = delete;
+
+    // The segment is mapped and holds a table with this Size and Value
+    bool isOpen() const
+    {
+        return header != nullptr;
+    }
+
+    bool isWriter() const
+    {
+        return isOpen() && segment.isWritable();
+    }
+
+    bool insert(KeyViewType key, const ValueType &value)
+    {
+        if (!isWriter())
+        {
+            return false;
+        }
+        uint32_t index = getHash(key);
+        const uint32_t startIndex = index;
+        uint32_t firstErasedIndex = Size;
+        // Walk the whole chain once, the key may exist after an erased slot
+        while (slots[index].state != SlotState::Empty)
+        {
+            if (slots[index].state == SlotState::Occupied && keysMatch(slots[index], key))
+            {
+                // Key exists, update value and move it to the beginning of the list
+                const WriteSection section(*header);
+                slots[index].value = value;
+                unlinkElement(index);
+                linkElement(index);
+                return true;
+            }
+            if (slots[index].state == SlotState::Erased && firstErasedIndex == Size)
+            {
+                firstErasedIndex = index;
+            }
+            // Linear probing
+            index = (index + ProbingFactor) % Size;
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        if (firstErasedIndex != Size)
+        {
+            index = firstErasedIndex;
+        }
+        else if (slots[index].state != SlotState::Empty)
+        {
+            // Table full
+            return false;
+        }
+
+        const WriteSection section(*header);
+        if (!storeKey(slots[index], key))
+        {
+            // Arena full
+            return false;
+        }
+        slots[index].value = value;
+        slots[index].state = SlotState::Occupied;
+        ++header->elementCount;
+        linkElement(index);
+
+        return true;
+    }
+
+    bool remove(KeyViewType key)
+    {
+        if (!isWriter())
+        {
+            return false;
+        }
+        const uint32_t index = getIndexFromProbing(key);
+        if (index == Size)
+        {
+            // Key not found
+            return false;
+        }
+
+        const WriteSection section(*header);
+        unlinkElement(index);
+        // Set erased in order to not break probing chains
+        slots[index].state = SlotState::Erased;
+        header->arenaHoles += slots[index].keyLength;
+        slots[index].keyLength = 0;
+        slots[index].value = ValueType{};
+        --header->elementCount;
+
+        return true;
+    }
+
+    // The writer moves the element to the beginning of the list, a reader only looks the key up
+    std::tuple<bool, ValueType> get(KeyViewType key)
+    {
+        if (!isWriter())
+        {
+            return peek(key);
+        }
+        const uint32_t index = getIndexFromProbing(key);
+        if (index == Size)
+        {
+            // Key not found
+            return std::make_tuple(false, ValueType{});
+        }
+        if (slots[FirstIndex].rightElement != index)
+        {
+            // Update LRU linked list since this element was just accessed
+            const WriteSection section(*header);
+            unlinkElement(index);
+            linkElement(index);
+        }
+        return std::make_tuple(true, slots[index].value);
+    }
+
+    // Look a key up without changing the LRU/MRU order
+    std::tuple<bool, ValueType> peek(KeyViewType key) const
+    {
+        if (!isOpen())
+        {
+            return std::make_tuple(false, ValueType{});
+        }
+        return readConsistent(
+            [this, key]() {
+                const uint32_t index = getIndexFromProbing(key);
+                return index == Size ? std::make_tuple(false, ValueType{})
+                                     : std::make_tuple(true, slots[index].value);
+            },
+            std::make_tuple(false, ValueType{}));
+    }
+
+    // Most recently used element
+    std::tuple<bool, KeyValuePair> get_last() const
+    {
+        return getElement([this]() { return slots[FirstIndex].rightElement; });
+    }
+
+    // Least recently used element
+    std::tuple<bool, KeyValuePair> get_first() const
+    {
+        return getElement([this]() { return slots[LastIndex].leftElement; });
+    }
+
+    uint32_t getHash(KeyViewType key) const
+    {
+        return static_cast<uint32_t>(hash_functions::hashBytes(key.data(), key.size()) % Size);
+    }
+
+    uint32_t size() const
+    {
+        return isOpen() ? readConsistent([this]() { return header->elementCount; }, uint32_t{0}) : 0;
+    }
+
+    // Bytes of the shared memory segment
+    size_t memoryUsage() const
+    {
+        return segment.size();
+    }
+
+private:
+    static constexpr uint32_t FirstIndex = Size;
+    static constexpr uint32_t LastIndex = Size + 1;
+    static constexpr char Magic[8] = {'S', 'H', 'T', 'A', 'B', 'L', 'E', '1'};
+    static constexpr uint32_t Version = 1;
+
+    enum class SlotState : uint8_t
+    {
+        Empty,
+        Occupied,
+        Erased,
+    };
+
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t valueSize;
+        uint32_t elementCount;
+        uint64_t arenaSize;
+        // End of the keys written to the arena and bytes of removed keys before it
+        uint64_t arenaUsed;
+        uint64_t arenaHoles;
+        // Odd while the writer changes the segment
+        std::atomic<uint64_t> sequence;
+        uint8_t reserved[8];
+    };
+    static_assert(sizeof(SegmentHeader) == 64, "Segment header must keep its size");
+
+    struct HashElement
+    {
+        uint32_t rightElement;
+        uint32_t leftElement;
+        uint64_t keyOffset;
+        uint32_t keyLength;
+        SlotState state;
+        ValueType value;
+    };
+
+    // Makes the sequence counter odd for the lifetime of the object
+    class WriteSection
+    {
+    public:
+        explicit WriteSection(SegmentHeader &segmentHeader) : header(segmentHeader)
+        {
+            header.sequence.store(header.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            // Readers that see a change made below also see the odd counter
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteSection()
+        {
+            header.sequence.store(header.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        WriteSection(const WriteSection &other) = delete;
+        WriteSection(WriteSection &&other) = delete;
+        WriteSection &operator=(const WriteSection &other) = delete;
+        WriteSection &operator=(WriteSection &&other) = delete;
+
+    private:
+        SegmentHeader &header;
+    };
+
+    static uint64_t getSlotsOffset()
+    {
+        return sizeof(SegmentHeader);
+    }
+
+    static uint64_t getArenaOffset()
+    {
+        return getSlotsOffset() + sizeof(HashElement) * (uint64_t{Size} + 2);
+    }
+
+    static size_t getSegmentSize(uint64_t arenaSize)
+    {
+        return static_cast<size_t>(getArenaOffset() + arenaSize);
+    }
+
+    void initialize(uint64_t arenaSize)
+    {
+        if (!segment.isOpen())
+        {
+            return;
+        }
+        // The segment is zero filled, so every slot is empty
+        auto *newHeader = new (segment.bytes()) SegmentHeader{};
+        newHeader->version = Version;
+        newHeader->slotCount = Size;
+        newHeader->valueSize = sizeof(ValueType);
+        newHeader->arenaSize = arenaSize;
+        setPointers(newHeader);
+        slots[FirstIndex].rightElement = LastIndex;
+        slots[LastIndex].leftElement = FirstIndex;
+        // Readers only accept the segment once the magic value is written
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(newHeader->magic, Magic, sizeof(Magic));
+    }
+
+    void attach()
+    {
+        if (!segment.isOpen() || segment.size() < getSegmentSize(0))
+        {
+            return;
+        }
+        auto *segmentHeader = reinterpret_cast<SegmentHeader *>(segment.bytes());
+        const bool valid = std::memcmp(segmentHeader->magic, Magic, sizeof(Magic)) == 0 &&
+                           segmentHeader->version == Version && segmentHeader->slotCount == Size &&
+                           segmentHeader->valueSize == sizeof(ValueType) &&
+                           segmentHeader->arenaSize <= segment.size() - getSegmentSize(0);
+        if (valid)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            setPointers(segmentHeader);
+            if (segment.isWritable() && (header->sequence.load(std::memory_order_relaxed) & 1) != 0)
+            {
+                recover();
+            }
+        }
+    }
+
+    // The previous writer died in the middle of a change, so the list, the counts and the arena ends may not
+    // match the slots. Rebuild them from the occupied slots and make the counter even so readers read again.
+    void recover()
+    {
+        slots[FirstIndex].rightElement = LastIndex;
+        slots[LastIndex].leftElement = FirstIndex;
+        uint32_t elementCount = 0;
+        uint64_t keyBytes = 0;
+        uint64_t arenaUsed = 0;
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            HashElement &element = slots[index];
+            if (element.state == SlotState::Occupied && !hasValidKey(element))
+            {
+                element.state = SlotState::Erased;
+                element.keyLength = 0;
+            }
+            if (element.state != SlotState::Occupied)
+            {
+                continue;
+            }
+            linkElement(index);
+            ++elementCount;
+            keyBytes += element.keyLength;
+            arenaUsed = std::max(arenaUsed, element.keyOffset + element.keyLength);
+        }
+        header->elementCount = elementCount;
+        // Keys may overlap if the writer died while moving one, count no holes then
+        header->arenaUsed = arenaUsed;
+        header->arenaHoles = arenaUsed - std::min(arenaUsed, keyBytes);
+        header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void setPointers(SegmentHeader *segmentHeader)
+    {
+        header = segmentHeader;
+        slots = reinterpret_cast<HashElement *>(segment.bytes() + getSlotsOffset());
+        arena = segment.bytes() + getArenaOffset();
+        arenaSize = segmentHeader->arenaSize;
+    }
+
+    // Run read until it ran while the writer changed nothing and return its result. What read sees may be
+    // inconsistent while the writer is active, so it must check indices and key bounds before following them.
+    // Return notRead if the counter stays at the same odd value for MaxStalledReads reads, the writer died then.
+    template<typename Read, typename Result>
+    Result readConsistent(Read read, Result notRead) const
+    {
+        uint64_t stalledSequence = 0;
+        uint32_t stalledReads = 0;
+        while (true)
+        {
+            const uint64_t before = header->sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0)
+            {
+                // A writer that is alive moves the counter on, so only count reads that see the same value
+                stalledReads = before == stalledSequence ? stalledReads + 1 : 1;
+                stalledSequence = before;
+                if (stalledReads >= MaxStalledReads)
+                {
+                    return notRead;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            auto result = read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return result;
+            }
+        }
+    }
+
+    template<typename GetIndex>
+    std::tuple<bool, KeyValuePair> getElement(GetIndex getIndex) const
+    {
+        if (!isOpen())
+        {
+            return std::make_tuple(false, KeyValuePair{});
+        }
+        return readConsistent(
+            [this, getIndex]() {
+                const uint32_t index = getIndex();
+                if (index >= Size || !hasValidKey(slots[index]))
+                {
+                    // Table is empty
+                    return std::make_tuple(false, KeyValuePair{});
+                }
+                auto keyValuePair = std::make_tuple(KeyType(getKey(slots[index])), slots[index].value);
+                return std::make_tuple(true, keyValuePair);
+            },
+            std::make_tuple(false, KeyValuePair{}));
+    }
+
+    bool hasValidKey(const HashElement &element) const
+    {
+        return element.keyOffset <= arenaSize && element.keyLength <= arenaSize - element.keyOffset;
+    }
+
+    KeyViewType getKey(const HashElement &element) const
+    {
+        return KeyViewType(arena + element.keyOffset, element.keyLength);
+    }
+
+    bool keysMatch(const HashElement &element, KeyViewType key) const
+    {
+        return element.keyLength == key.size() && hasValidKey(element) && getKey(element) == key;
+    }
+
+    // Append the key to the arena, compacting it first if the key does not fit at its end
+    bool storeKey(HashElement &element, KeyViewType key)
+    {
+        if (key.size() > arenaSize - header->arenaUsed)
+        {
+            if (key.size() > arenaSize - header->arenaUsed + header->arenaHoles)
+            {
+                return false;
+            }
+            compactArena();
+        }
+        std::memcpy(arena + header->arenaUsed, key.data(), key.size());
+        element.keyOffset = header->arenaUsed;
+        element.keyLength = static_cast<uint32_t>(key.size());
+        header->arenaUsed += key.size();
+        return true;
+    }
+
+    // Move the keys still in use to the beginning of the arena in the order they are in, so every key moves to
+    // a lower offset and no key is overwritten before it is moved
+    void compactArena()
+    {
+        std::vector<uint32_t> occupied;
+        occupied.reserve(header->elementCount);
+        for (uint32_t index = 0; index < Size; ++index)
+        {
+            if (slots[index].state == SlotState::Occupied)
+            {
+                occupied.push_back(index);
+            }
+        }
+        std::sort(occupied.begin(), occupied.end(),
+                  [this](uint32_t a, uint32_t b) { return slots[a].keyOffset < slots[b].keyOffset; });
+        uint64_t used = 0;
+        for (const uint32_t index : occupied)
+        {
+            std::memmove(arena + used, arena + slots[index].keyOffset, slots[index].keyLength);
+            slots[index].keyOffset = used;
+            used += slots[index].keyLength;
+        }
+        header->arenaUsed = used;
+        header->arenaHoles = 0;
+    }
+
+    // At most Size slots are looked at, so a reader cannot loop on slots the writer is changing
+    uint32_t getIndexFromProbing(KeyViewType key) const
+    {
+        uint32_t index = getHash(key);
+        const uint32_t startIndex = index;
+        // Erased slots do not break the probing chain, only an empty slot ends it
+        while (slots[index].state != SlotState::Empty)
+        {
+            if (slots[index].state == SlotState::Occupied && keysMatch(slots[index], key))
+            {
+                return index;
+            }
+            // Linear probing
+            index = (index + ProbingFactor) % Size;
+            if (index == startIndex)
+            {
+                break;
+            }
+        }
+        return Size; // Indicate not found
+    }
+
+    void linkElement(uint32_t index)
+    {
+        // Link this element to the beginning of the list
+        // Left to right connection
+        const uint32_t temp = slots[FirstIndex].rightElement;
+        slots[FirstIndex].rightElement = index;
+        slots[index].rightElement = temp;
+
+        // Right to left connection
+        slots[temp].leftElement = index;
+        slots[index].leftElement = FirstIndex;
+    }
+
+    void unlinkElement(uint32_t index)
+    {
+        // Unlink the element from the double linked list
+        slots[slots[index].leftElement].rightElement = slots[index].rightElement;
+        slots[slots[index].rightElement].leftElement = slots[index].leftElement;
+    }
+
+    SharedMemorySegment segment;
+    // Pointers into the segment, null if it is not open or not a valid table
+    SegmentHeader *header = nullptr;
+    HashElement *slots = nullptr;
+    char *arena = nullptr;
+    uint64_t arenaSize = 0;
+};
+
+#endif // SHARED_HASH_TABLE_H
@@ -0,0 +1,66 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <cstddef>
+#include <string>
+
+// Whether a process maps a shared memory segment to change it or only to read it
+enum class SegmentAccess
+{
+    ReadWrite,
+    ReadOnly,
+};
+
+// Shared mapping of a POSIX shared memory object (shm_open) or of a file descriptor such as one returned by
+// memfd_create, so several processes see the same bytes. The segment is unmapped when the object is destroyed,
+// the shared memory object itself stays until remove is called.
+class SharedMemorySegment
+{
+public:
+    // Create the shared memory object name, or truncate an existing one, and map size zero filled bytes
+    SharedMemorySegment(const std::string &name, size_t size);
+    // Map an existing shared memory object name with its current size
+    SharedMemorySegment(const std::string &name, SegmentAccess access);
+    // Resize the file descriptor to size zero filled bytes and map it, the descriptor stays owned by the caller
+    SharedMemorySegment(int fd, size_t size);
+    // Map a file descriptor with its current size, the descriptor stays owned by the caller
+    SharedMemorySegment(int fd, SegmentAccess access);
+    ~SharedMemorySegment();
+    SharedMemorySegment(const SharedMemorySegment &other) = delete;
+    SharedMemorySegment(SharedMemorySegment &&other) = delete;
+    SharedMemorySegment &operator=(const SharedMemorySegment &other) = delete;
+    SharedMemorySegment &operator=(SharedMemorySegment &&other) = delete;
+
+    // Remove the shared memory object name, processes that mapped it keep their mapping
+    static bool remove(const std::string &name);
+
+    bool isOpen() const
+    {
+        return data != nullptr;
+    }
+
+    bool isWritable() const
+    {
+        return writable;
+    }
+
+    char *bytes() const
+    {
+        return data;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    void create(int fd, size_t size);
+    void map(int fd, SegmentAccess access);
+
+    char *data = nullptr;
+    size_t length = 0;
+    bool writable = false;
+};
+
+#endif // SHARED_MEMORY_H
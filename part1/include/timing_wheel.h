@@ -0,0 +1,257 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// Hierarchical timing wheel that tracks the expiry tick of the slots of a HashTable, used for per element TTLs.
+//
+// How expiry works:
+// 1. There are 4 levels of 64 buckets. A bucket of level 0 covers 1 tick, a bucket of level 1 covers 64 ticks,
+// level 2 covers 64^2 ticks and level 3 covers 64^3 ticks, so expiries up to 64^4 ticks ahead are tracked.
+// Later expiries are put at the end of level 3 and placed again when that bucket is reached.
+//
+// 2. Every slot has one entry with its expiry tick and the links of a double linked list of the bucket it is
+// in, so scheduling and cancelling are O(1) and nothing is allocated after the entries.
+//
+// 3. Advancing the wheel by one tick first moves the entries of the bucket of a higher level to lower levels
+// when the tick crosses the boundary of that bucket (cascading), and then expires every entry of the level 0
+// bucket of the tick. An entry is cascaded at most 3 times, so expiring is O(1) amortized per entry and the
+// table is never swept.
+//
+// 4. Every level has a 64-bit mask of its non-empty buckets. Advancing jumps over the ticks whose level 0
+// bucket is empty and whose cascades would move nothing, so a long time without operations costs a few steps
+// per level instead of one step per tick.
+class TimingWheel
+{
+public:
+    static constexpr uint32_t Levels = 4;
+    static constexpr uint32_t BucketBits = 6;
+    static constexpr uint32_t BucketsPerLevel = 1U << BucketBits;
+    static constexpr uint32_t NoEntry = UINT32_MAX;
+
+    TimingWheel(uint32_t capacity, uint64_t now) : entries(std::make_unique<Entry[]>(capacity)), currentTick(now)
+    {
+        heads.fill(NoEntry);
+    }
+    ~TimingWheel() = default;
+    TimingWheel(const TimingWheel &other) = delete;
+    TimingWheel(TimingWheel &&other) = delete;
+    TimingWheel &operator=(const TimingWheel &other) = delete;
+    TimingWheel &operator=(TimingWheel &&other) = delete;
+
+    // Last tick the wheel was advanced to
+    uint64_t now() const
+    {
+        return currentTick;
+    }
+
+    bool isScheduled(uint32_t index) const
+    {
+        return entries[index].bucket != NoEntry;
+    }
+
+    uint64_t expiry(uint32_t index) const
+    {
+        return entries[index].expiry;
+    }
+
+    // Schedule or reschedule a slot to expire at expiryTick, which is moved to the next tick if it is not after
+    // the current one
+    void schedule(uint32_t index, uint64_t expiryTick)
+    {
+        cancel(index);
+        entries[index].expiry = expiryTick > currentTick ? expiryTick : currentTick + 1;
+        place(index);
+        ++scheduledCount;
+    }
+
+    void cancel(uint32_t index)
+    {
+        if (!isScheduled(index))
+        {
+            return;
+        }
+        detach(index);
+        --scheduledCount;
+    }
+
+    // Cancel every entry
+    void clear()
+    {
+        for (uint32_t &head : heads)
+        {
+            while (head != NoEntry)
+            {
+                const uint32_t index = head;
+                head = entries[index].next;
+                entries[index].bucket = NoEntry;
+            }
+        }
+        levelMasks.fill(0);
+        scheduledCount = 0;
+    }
+
+    // Advance to tick now and call expire with the slot index of every entry whose expiry is not after now. The
+    // entry is cancelled before expire is called.
+    template<typename Expire>
+    void advance(uint64_t now, Expire expire)
+    {
+        while (currentTick < now)
+        {
+            const uint64_t nextTick = scheduledCount == 0 ? now + 1 : getNextBusyTick();
+            if (nextTick > now)
+            {
+                // Nothing to do until now
+                currentTick = now;
+                break;
+            }
+            currentTick = nextTick;
+            // Higher levels first, an entry cascaded from level 3 can land in the level 2 bucket cascaded next
+            for (uint32_t level = Levels - 1; level > 0; --level)
+            {
+                const uint64_t levelMask = (uint64_t{1} << (BucketBits * level)) - 1;
+                if ((currentTick & levelMask) == 0)
+                {
+                    cascade(getBucket(level, currentTick));
+                }
+            }
+
+            uint32_t index = takeBucket(getBucket(0, currentTick));
+            while (index != NoEntry)
+            {
+                const uint32_t next = entries[index].next;
+                entries[index].bucket = NoEntry;
+                if (entries[index].expiry <= currentTick)
+                {
+                    --scheduledCount;
+                    expire(index);
+                }
+                else
+                {
+                    // Expiry beyond the range of the wheel, place it again
+                    place(index);
+                }
+                index = next;
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t expiry = 0;
+        uint32_t next = NoEntry;
+        uint32_t previous = NoEntry;
+        // Bucket the entry is in, NoEntry if it is not scheduled
+        uint32_t bucket = NoEntry;
+    };
+
+    // First tick after currentTick with a non-empty level 0 bucket or a boundary where a non-empty level may be
+    // cascaded
+    uint64_t getNextBusyTick() const
+    {
+        if (levelMasks[0] != 0)
+        {
+            // Bit i of rotated is the bucket of tick currentTick + 1 + i
+            const uint32_t position = static_cast<uint32_t>((currentTick + 1) & (BucketsPerLevel - 1));
+            const uint64_t rotated =
+                (levelMasks[0] >> position) | (levelMasks[0] << ((BucketsPerLevel - position) & (BucketsPerLevel - 1)));
+            const uint64_t nextExpiry = currentTick + 1 + static_cast<uint64_t>(__builtin_ctzll(rotated));
+            const uint64_t nextBoundary = (currentTick | (BucketsPerLevel - 1)) + 1;
+            return nextExpiry < nextBoundary ? nextExpiry : nextBoundary;
+        }
+        // The levels below the first non-empty one have nothing to cascade, go to the next boundary of that level
+        uint32_t level = 1;
+        while (level + 1 < Levels && levelMasks[level] == 0)
+        {
+            ++level;
+        }
+        const uint64_t levelSpan = uint64_t{1} << (BucketBits * level);
+        return (currentTick | (levelSpan - 1)) + 1;
+    }
+
+    // Remove the whole list of a bucket and return its first entry
+    uint32_t takeBucket(uint32_t bucket)
+    {
+        const uint32_t index = heads[bucket];
+        heads[bucket] = NoEntry;
+        levelMasks[bucket / BucketsPerLevel] &= ~(uint64_t{1} << (bucket % BucketsPerLevel));
+        return index;
+    }
+
+    static uint32_t getBucket(uint32_t level, uint64_t tick)
+    {
+        return level * BucketsPerLevel + static_cast<uint32_t>((tick >> (BucketBits * level)) & (BucketsPerLevel - 1));
+    }
+
+    // Put an entry into the lowest level whose buckets reach its expiry, the expiry is never before currentTick
+    void place(uint32_t index)
+    {
+        constexpr uint64_t MaxDelta = (uint64_t{1} << (BucketBits * Levels)) - 1;
+        uint64_t target = entries[index].expiry > currentTick ? entries[index].expiry : currentTick;
+        if (target - currentTick > MaxDelta)
+        {
+            target = currentTick + MaxDelta;
+        }
+        uint32_t level = 0;
+        while (level + 1 < Levels && target - currentTick >= (uint64_t{1} << (BucketBits * (level + 1))))
+        {
+            ++level;
+        }
+        const uint32_t bucket = getBucket(level, target);
+        entries[index].bucket = bucket;
+        entries[index].previous = NoEntry;
+        entries[index].next = heads[bucket];
+        if (heads[bucket] != NoEntry)
+        {
+            entries[heads[bucket]].previous = index;
+        }
+        heads[bucket] = index;
+        levelMasks[level] |= uint64_t{1} << (bucket % BucketsPerLevel);
+    }
+
+    void detach(uint32_t index)
+    {
+        Entry &entry = entries[index];
+        if (entry.previous != NoEntry)
+        {
+            entries[entry.previous].next = entry.next;
+        }
+        else
+        {
+            heads[entry.bucket] = entry.next;
+            if (entry.next == NoEntry)
+            {
+                levelMasks[entry.bucket / BucketsPerLevel] &= ~(uint64_t{1} << (entry.bucket % BucketsPerLevel));
+            }
+        }
+        if (entry.next != NoEntry)
+        {
+            entries[entry.next].previous = entry.previous;
+        }
+        entry.bucket = NoEntry;
+    }
+
+    // Move every entry of a bucket to the level its expiry now belongs to
+    void cascade(uint32_t bucket)
+    {
+        uint32_t index = takeBucket(bucket);
+        while (index != NoEntry)
+        {
+            const uint32_t next = entries[index].next;
+            place(index);
+            index = next;
+        }
+    }
+
+    std::unique_ptr<Entry[]> entries;
+    std::array<uint32_t, Levels * BucketsPerLevel> heads{};
+    // Bit b of levelMasks[level] is set if bucket b of the level is not empty
+    std::array<uint64_t, Levels> levelMasks{};
+    uint64_t currentTick;
+    uint32_t scheduledCount = 0;
+};
+
+#endif // TIMING_WHEEL_H
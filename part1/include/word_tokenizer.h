@@ -0,0 +1,102 @@
+#ifndef WORD_TOKENIZER_H
+#define WORD_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include <immintrin.h>
+
+// Splits text into words separated by whitespace, the same words std::istream >> std::string gives with the
+// default locale (space, \t, \n, \v, \f and \r are whitespace). Words are passed to the callback as views into
+// the text, so there is no allocation per word.
+//
+// How tokenizing works:
+// 1. With AVX2, 32 bytes are compared against the whitespace characters at once and the result is turned
+// into a 32-bit mask with one bit per byte that is part of a word.
+//
+// 2. The mask is xored with itself shifted by one bit (carrying the last bit of the previous block), which
+// leaves a bit set exactly where a word starts or ends. These bits are visited with count trailing zeros.
+//
+// 3. The last partial block is copied into a 32 byte buffer padded with spaces and processed the same way.
+class WordTokenizer
+{
+public:
+    static constexpr size_t BlockSize = 32;
+
+    // Call onWord(std::string_view) for every word in the text and return the number of words
+    template<typename Callback>
+    static size_t tokenize(std::string_view text, Callback onWord)
+    {
+        size_t wordCount = 0;
+        size_t wordStart = 0;
+        uint32_t previousWordBit = 0;
+        size_t i = 0;
+
+        const auto processBlock = [&](uint32_t wordMask, size_t blockStart) {
+            uint32_t transitions = wordMask ^ ((wordMask << 1) | previousWordBit);
+            while (transitions != 0)
+            {
+                const uint32_t bit = __builtin_ctz(transitions);
+                if ((wordMask >> bit) & 1U)
+                {
+                    wordStart = blockStart + bit;
+                }
+                else
+                {
+                    onWord(std::string_view(text.data() + wordStart, blockStart + bit - wordStart));
+                    ++wordCount;
+                }
+                // clear least significant 1 bit
+                transitions &= transitions - 1;
+            }
+            previousWordBit = wordMask >> 31;
+        };
+
+        for (; i + BlockSize <= text.size(); i += BlockSize)
+        {
+            processBlock(getWordMask(text.data() + i), i);
+        }
+
+        // Tail, pad with spaces so the block is a whole one and a word at the end of the text is closed
+        if (i < text.size() || previousWordBit != 0)
+        {
+            char tail[BlockSize];
+            std::memset(tail, ' ', BlockSize);
+            std::memcpy(tail, text.data() + i, text.size() - i);
+            processBlock(getWordMask(tail), i);
+        }
+
+        return wordCount;
+    }
+
+    static bool isWhitespace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+private:
+    // One bit per byte of the 32 byte block that is not whitespace
+    static uint32_t getWordMask(const char *block)
+    {
+#ifdef __AVX2__
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        const __m256i isSpace = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+        // \t to \r are 9 to 13, so after subtracting 9 they are the only bytes with an unsigned value up to 4
+        const __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+        const __m256i isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+        const __m256i isWhitespaceVectorized = _mm256_or_si256(isSpace, isControl);
+        return ~static_cast<uint32_t>(_mm256_movemask_epi8(isWhitespaceVectorized));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < BlockSize; ++i)
+        {
+            mask |= static_cast<uint32_t>(!isWhitespace(block[i])) << i;
+        }
+        return mask;
+#endif
+    }
+};
+
+#endif // WORD_TOKENIZER_H
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "hash_table.h"
+
+// Offline benchmark of HashTable against std::unordered_map on synthetic key streams, no download needed.
+//
+// For every table size, load factor and key distribution a set of keyCount = size * loadFactor distinct keys
+// is made and a stream of operations picks keys from it:
+// - uniform: every key equally likely
+// - zipf: key ranks follow a Zipf distribution with exponent 0.99, the hot keys are spread over the key set
+// - sequential: the keys in order, wrapping around
+//
+// Workloads, each on a fresh table:
+// - insert: insert the stream into an empty table, repeated keys update their value
+// - get: look up the stream in a table holding every key
+// - remove: remove the stream from a table holding every key, repeated keys miss
+// - mixed: 80% get, 15% insert and 5% remove on a table holding every key
+//
+// Every measurement is printed as one JSON object per line so results can be compared between releases.
+//
+// Usage: part1_benchmark [--quick]
+
+namespace
+{
+constexpr uint64_t Seed = 20240601;
+constexpr double ZipfExponent = 0.99;
+constexpr std::array<double, 4> LoadFactors = {0.25, 0.5, 0.75, 0.9};
+
+enum class Distribution
+{
+    Uniform,
+    Zipf,
+    Sequential,
+};
+
+enum class Workload
+{
+    Insert,
+    Get,
+    Remove,
+    Mixed,
+};
+
+const char *toString(Distribution distribution)
+{
+    switch (distribution)
+    {
+    case Distribution::Uniform:
+        return "uniform";
+    case Distribution::Zipf:
+        return "zipf";
+    case Distribution::Sequential:
+        return "sequential";
+    }
+    return "";
+}
+
+const char *toString(Workload workload)
+{
+    switch (workload)
+    {
+    case Workload::Insert:
+        return "insert";
+    case Workload::Get:
+        return "get";
+    case Workload::Remove:
+        return "remove";
+    case Workload::Mixed:
+        return "mixed";
+    }
+    return "";
+}
+
+// Draws ranks in [0, count) with probability proportional to 1 / (rank + 1)^exponent from a precomputed
+// cumulative distribution
+class ZipfGenerator
+{
+public:
+    ZipfGenerator(uint32_t count, double exponent) : cumulative(count)
+    {
+        double sum = 0.0;
+        for (uint32_t rank = 0; rank < count; ++rank)
+        {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+            cumulative[rank] = sum;
+        }
+        for (double &value : cumulative)
+        {
+            value /= sum;
+        }
+    }
+
+    uint32_t operator()(std::mt19937_64 &random) const
+    {
+        const double draw = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        const auto rank = std::lower_bound(cumulative.begin(), cumulative.end(), draw) - cumulative.begin();
+        return static_cast<uint32_t>(std::min<ptrdiff_t>(rank, static_cast<ptrdiff_t>(cumulative.size()) - 1));
+    }
+
+private:
+    std::vector<double> cumulative;
+};
+
+// Keys and the operation stream of one measurement, generated before any timing
+struct BenchmarkCase
+{
+    Distribution distribution = Distribution::Uniform;
+    uint32_t tableSize = 0;
+    double loadFactor = 0.0;
+    std::vector<std::string> keys;
+    // Index into keys of every operation
+    std::vector<uint32_t> stream;
+    // Operation of every step of the mixed workload, 0 get, 1 insert, 2 remove
+    std::vector<uint8_t> mixedOperations;
+};
+
+BenchmarkCase makeCase(Distribution distribution, uint32_t tableSize, double loadFactor, size_t operationCount)
+{
+    BenchmarkCase benchmarkCase;
+    benchmarkCase.distribution = distribution;
+    benchmarkCase.tableSize = tableSize;
+    benchmarkCase.loadFactor = loadFactor;
+
+    std::mt19937_64 random(Seed ^ tableSize ^ static_cast<uint64_t>(loadFactor * 1000));
+    const auto keyCount = static_cast<uint32_t>(tableSize * loadFactor);
+    benchmarkCase.keys.reserve(keyCount);
+    for (uint32_t i = 0; i < keyCount; ++i)
+    {
+        benchmarkCase.keys.push_back("key" + std::to_string(random()));
+    }
+
+    benchmarkCase.stream.resize(operationCount);
+    if (distribution == Distribution::Uniform)
+    {
+        std::uniform_int_distribution<uint32_t> uniform(0, keyCount - 1);
+        for (uint32_t &index : benchmarkCase.stream)
+        {
+            index = uniform(random);
+        }
+    }
+    else if (distribution == Distribution::Zipf)
+    {
+        // Map ranks to keys through a permutation so the hot keys are not the first keys inserted
+        std::vector<uint32_t> keyOfRank(keyCount);
+        for (uint32_t rank = 0; rank < keyCount; ++rank)
+        {
+            keyOfRank[rank] = rank;
+        }
+        std::shuffle(keyOfRank.begin(), keyOfRank.end(), random);
+        const ZipfGenerator zipf(keyCount, ZipfExponent);
+        for (uint32_t &index : benchmarkCase.stream)
+        {
+            index = keyOfRank[zipf(random)];
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < operationCount; ++i)
+        {
+            benchmarkCase.stream[i] = static_cast<uint32_t>(i % keyCount);
+        }
+    }
+
+    benchmarkCase.mixedOperations.resize(operationCount);
+    std::uniform_int_distribution<uint32_t> percent(0, 99);
+    for (uint8_t &operation : benchmarkCase.mixedOperations)
+    {
+        const uint32_t draw = percent(random);
+        operation = draw < 80 ? 0 : (draw < 95 ? 1 : 2);
+    }
+    return benchmarkCase;
+}
+
+// Same operations on both implementations so the workloads are written once
+template<uint32_t Size>
+class HashTableAdapter
+{
+public:
+    static constexpr const char *Name = "HashTable";
+
+    explicit HashTableAdapter(uint32_t /*keyCount*/) {}
+
+    bool insert(const std::string &key, uint32_t value)
+    {
+        return table.insert(key, value);
+    }
+
+    bool get(const std::string &key, uint32_t &value)
+    {
+        const auto result = table.get(key);
+        value = std::get<1>(result);
+        return std::get<0>(result);
+    }
+
+    bool remove(const std::string &key)
+    {
+        return table.remove(key);
+    }
+
+private:
+    HashTable<Size> table;
+};
+
+class UnorderedMapAdapter
+{
+public:
+    static constexpr const char *Name = "std::unordered_map";
+
+    explicit UnorderedMapAdapter(uint32_t keyCount)
+    {
+        map.reserve(keyCount);
+    }
+
+    bool insert(const std::string &key, uint32_t value)
+    {
+        map[key] = value;
+        return true;
+    }
+
+    bool get(const std::string &key, uint32_t &value)
+    {
+        const auto found = map.find(key);
+        if (found == map.end())
+        {
+            return false;
+        }
+        value = found->second;
+        return true;
+    }
+
+    bool remove(const std::string &key)
+    {
+        return map.erase(key) != 0;
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> map;
+};
+
+// Run one workload on a fresh table and return the nanoseconds per operation. Results are folded into checksum
+// so the compiler cannot drop the lookups.
+template<typename Adapter>
+double runWorkload(Workload workload, const BenchmarkCase &benchmarkCase, uint64_t &checksum)
+{
+    const auto keyCount = static_cast<uint32_t>(benchmarkCase.keys.size());
+    auto table = std::make_unique<Adapter>(keyCount);
+    if (workload != Workload::Insert)
+    {
+        for (uint32_t i = 0; i < keyCount; ++i)
+        {
+            table->insert(benchmarkCase.keys[i], i);
+        }
+    }
+
+    const std::vector<uint32_t> &stream = benchmarkCase.stream;
+    uint64_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    switch (workload)
+    {
+    case Workload::Insert:
+        for (size_t i = 0; i < stream.size(); ++i)
+        {
+            sum += table->insert(benchmarkCase.keys[stream[i]], static_cast<uint32_t>(i)) ? 1 : 0;
+        }
+        break;
+    case Workload::Get:
+        for (const uint32_t index : stream)
+        {
+            uint32_t value = 0;
+            sum += table->get(benchmarkCase.keys[index], value) ? value : 0;
+        }
+        break;
+    case Workload::Remove:
+        for (const uint32_t index : stream)
+        {
+            sum += table->remove(benchmarkCase.keys[index]) ? 1 : 0;
+        }
+        break;
+    case Workload::Mixed:
+        for (size_t i = 0; i < stream.size(); ++i)
+        {
+            const std::string &key = benchmarkCase.keys[stream[i]];
+            uint32_t value = 0;
+            if (benchmarkCase.mixedOperations[i] == 0)
+            {
+                sum += table->get(key, value) ? value : 0;
+            }
+            else if (benchmarkCase.mixedOperations[i] == 1)
+            {
+                sum += table->insert(key, static_cast<uint32_t>(i)) ? 1 : 0;
+            }
+            else
+            {
+                sum += table->remove(key) ? 1 : 0;
+            }
+        }
+        break;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    checksum += sum;
+
+    const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+    return nanoseconds / static_cast<double>(stream.size());
+}
+
+template<typename Adapter>
+void reportWorkloads(const BenchmarkCase &benchmarkCase, uint64_t &checksum)
+{
+    for (const Workload workload : {Workload::Insert, Workload::Get, Workload::Remove, Workload::Mixed})
+    {
+        const double nanosecondsPerOperation = runWorkload<Adapter>(workload, benchmarkCase, checksum);
+        std::cout << "{\"implementation\":\"" << Adapter::Name << "\",\"distribution\":\""
+                  << toString(benchmarkCase.distribution) << "\",\"table_size\":" << benchmarkCase.tableSize
+                  << ",\"load_factor\":" << benchmarkCase.loadFactor << ",\"keys\":" << benchmarkCase.keys.size()
+                  << ",\"workload\":\"" << toString(workload) << "\",\"operations\":" << benchmarkCase.stream.size()
+                  << ",\"ns_per_op\":" << std::fixed << std::setprecision(2) << nanosecondsPerOperation
+                  << std::defaultfloat << std::setprecision(6) << "}\n";
+    }
+}
+
+template<uint32_t Size>
+void benchmarkSize(size_t operationCount, uint64_t &checksum)
+{
+    for (const double loadFactor : LoadFactors)
+    {
+        for (const Distribution distribution : {Distribution::Uniform, Distribution::Zipf, Distribution::Sequential})
+        {
+            const BenchmarkCase benchmarkCase = makeCase(distribution, Size, loadFactor, operationCount);
+            reportWorkloads<HashTableAdapter<Size>>(benchmarkCase, checksum);
+            reportWorkloads<UnorderedMapAdapter>(benchmarkCase, checksum);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // A quick run for checking that the benchmark works, not for comparing numbers
+    const bool quick = argc > 1 && std::string(argv[1]) == "--quick";
+    const size_t operationCount = quick ? (1U << 14) : (1U << 20);
+
+    uint64_t checksum = 0;
+    benchmarkSize<1U << 12>(operationCount, checksum);
+    benchmarkSize<1U << 16>(operationCount, checksum);
+    if (!quick)
+    {
+        benchmarkSize<1U << 20>(operationCount, checksum);
+    }
+
+    // Printed to stderr so stdout stays one JSON object per line
+    std::cerr << "checksum " << checksum << std::endl;
+    return 0;
+}
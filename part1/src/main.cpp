@@ -1,11 +1,38 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 #include <curl/curl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+#include "compact_hash_table.h"
+#include "frozen_hash_table.h"
+#include "frequency_sketch.h"
+#include "growable_hash_table.h"
 #include "hash_table.h"
+#include "hash_table_simd.h"
+#include "hash_table_snapshot.h"
+#include "hash_table_stats.h"
+#include "mapped_file.h"
+#include "parallel_word_count.h"
+#include "robin_hood_hash_table.h"
+#include "shared_hash_table.h"
+#include "sharded_hash_table.h"
+#include "word_tokenizer.h"
 
 static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -14,10 +41,9 @@ static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdat
     return size * nmemb;
 }
 
-std::vector<std::string> download_and_parse_words(const std::string &url)
+std::string download_text(const std::string &url)
 {
     std::string content;
-    std::vector<std::string> words;
 
     curl_global_init(CURL_GLOBAL_DEFAULT);
     CURL *curl = curl_easy_init();
@@ -38,53 +64,62 @@ std::vector<std::string> download_and_parse_words(const std::string &url)
     }
     curl_global_cleanup();
 
-    std::istringstream stream(content);
-    std::string word;
-    while (stream >> word)
-    {
-        words.push_back(word);
-    }
-
-    return words;
+    return content;
 }
 
-int main()
+// Usage: part1 [path to a local text file], without a path the book is downloaded
+int main(int argc, char *argv[])
 {
-    std::cout << "Downloading book\n";
-    std::vector<std::string> words = download_and_parse_words("https://www.gutenberg.org/files/98/98-0.txt");
-
-    for (size_t i = 0; i < 10 && i < words.size(); ++i)
+    // The text is either a memory mapped local file or the downloaded buffer, it is tokenized in place and the
+    // words are only views into it
+    std::string downloadedText;
+    std::unique_ptr<MappedFile> mappedFile;
+    std::string_view text;
+    if (argc > 1)
     {
-        std::cout << words[i] << "\n";
+        std::cout << "Mapping " << argv[1] << "\n";
+        mappedFile = std::make_unique<MappedFile>(argv[1]);
+        if (!mappedFile->isOpen())
+        {
+            std::cerr << "Opening " << argv[1] << " failed" << std::endl;
+        }
+        text = mappedFile->contents();
+    }
+    else
+    {
+        std::cout << "Downloading book\n";
+        downloadedText = download_text("https://www.gutenberg.org/files/98/98-0.txt");
+        text = downloadedText;
     }
 
-    std::cout << "\nTotal words: " << words.size() << "\n";
-
-    const uint32_t tableSize = 20000;
+    // Power of two size so slots are found with a mask instead of a modulo
+    const uint32_t tableSize = 1U << 15;
 
     HashTable<tableSize> bookHashTable;
 
-    for (const auto &word : words)
+    // Count on every core, each thread counts a part of the text into its own table and the tables are merged
+    const uint32_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+    size_t totalWords = 0;
+    if (!countWordsParallel(text, threadCount, bookHashTable, &totalWords))
     {
-        auto getResult = bookHashTable.get(word);
-        const bool sucess = std::get<0>(getResult);
-        if (sucess)
-        {
-            const uint32_t currentCount = std::get<1>(getResult);
-            const bool insertSucess = bookHashTable.insert(word, currentCount + 1);
-            if (!insertSucess)
-            {
-                std::cerr << "Failed to update count for word: " << word << "\n";
-            }
-        }
-        else
+        std::cerr << "Failed to count every word, the table is full\n";
+    }
+
+    size_t printedWords = 0;
+    WordTokenizer::tokenize(text.substr(0, 1024), [&printedWords](std::string_view word) {
+        if (printedWords < 10)
         {
-            const bool insertSucess = bookHashTable.insert(word, 1);
-            if (!insertSucess)
-            {
-                std::cerr << "Failed to update count for word: " << word << "\n";
-            }
+            std::cout << word << "\n";
+            ++printedWords;
         }
+    });
+
+    std::cout << "\nTotal words: " << totalWords << "\n";
+
+    std::cout << "\nMost frequent words:\n";
+    for (const auto &[word, count] : bookHashTable.top_k_by_value(10))
+    {
+        std::cout << word << " " << count << "\n";
     }
 
     // Test the book hash table
@@ -234,5 +269,1212 @@ int main()
         std::cout << "Error in get_last on empty table after removing only element" << std::endl;
     }
 
+
+    // Tests for growable hash table //
+
+    // Insert more keys than the initial capacity so the table has to grow several times
+    GrowableHashTable growableTable(8);
+    const uint32_t growableKeys = 1000;
+    for (uint32_t i = 0; i < growableKeys; ++i)
+    {
+        if (!growableTable.insert("key" + std::to_string(i), i))
+        {
+            std::cout << "Error in growable insert" << std::endl;
+        }
+    }
+    if (growableTable.size() != growableKeys || growableTable.capacity() < growableKeys)
+    {
+        std::cout << "Error in growable size after growing" << std::endl;
+    }
+    // key0 was inserted first so it must still be the least recently used after all the moves
+    const auto growableFirst = growableTable.get_first();
+    if (!(std::get<0>(growableFirst) && std::get<0>(std::get<1>(growableFirst)) == "key0"))
+    {
+        std::cout << "Error in growable get_first after growing" << std::endl;
+    }
+    for (uint32_t i = 0; i < growableKeys; ++i)
+    {
+        const auto growableGet = growableTable.get("key" + std::to_string(i));
+        if (!(std::get<0>(growableGet) && std::get<1>(growableGet) == i))
+        {
+            std::cout << "Error in growable get after growing" << std::endl;
+        }
+    }
+    // Every key was accessed in order so the last accessed is the most recently used
+    const auto growableLast = growableTable.get_last();
+    if (!(std::get<0>(growableLast) && std::get<0>(std::get<1>(growableLast)) == "key999"))
+    {
+        std::cout << "Error in growable get_last after growing" << std::endl;
+    }
+    // Remove half of the keys and check the rest are still there
+    for (uint32_t i = 0; i < growableKeys; i += 2)
+    {
+        if (!growableTable.remove("key" + std::to_string(i)))
+        {
+            std::cout << "Error in growable remove" << std::endl;
+        }
+    }
+    if (growableTable.size() != growableKeys / 2 || std::get<0>(growableTable.get("key0")) ||
+        !std::get<0>(growableTable.get("key1")))
+    {
+        std::cout << "Error in growable get after remove" << std::endl;
+    }
+    // Inserts and removes that leave mostly tombstones rehash the table over and over while migration steps only
+    // scan a bounded number of old slots, no key may be lost
+    GrowableHashTable churnTable(8);
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        churnTable.insert("churn" + std::to_string(i), i);
+        if (i % 4 != 0)
+        {
+            churnTable.remove("churn" + std::to_string(i));
+        }
+    }
+    bool churnFound = churnTable.size() == 5000;
+    for (uint32_t i = 0; i < 20000; i += 4)
+    {
+        const auto churnGet = churnTable.get("churn" + std::to_string(i));
+        churnFound = churnFound && std::get<0>(churnGet) && std::get<1>(churnGet) == i;
+    }
+    if (!churnFound || std::get<0>(churnTable.get("churn1")))
+    {
+        std::cout << "Error in growable get after inserts and removes" << std::endl;
+    }
+
+
+    // Tests for LRU cache mode //
+
+    // Inserting in a full table must evict the least recently used element instead of failing
+    HashTableOptions cacheOptions;
+    cacheOptions.capacityPolicy = CapacityPolicy::EvictLeastRecentlyUsed;
+    std::vector<std::string> evictedKeys;
+    HashTable<3> cacheTable(cacheOptions,
+                            [&evictedKeys](const std::string &key, const uint32_t) { evictedKeys.push_back(key); });
+    cacheTable.insert("one", 1);
+    cacheTable.insert("two", 2);
+    cacheTable.insert("three", 3);
+    // Access one so two becomes the least recently used
+    cacheTable.get("one");
+    if (!cacheTable.insert("four", 4))
+    {
+        std::cout << "Error in insert with eviction" << std::endl;
+    }
+    if (!(evictedKeys.size() == 1 && evictedKeys[0] == "two") || std::get<0>(cacheTable.get("two")))
+    {
+        std::cout << "Error in eviction of least recently used" << std::endl;
+    }
+    const auto cacheFour = cacheTable.get("four");
+    if (!(std::get<0>(cacheFour) && std::get<1>(cacheFour) == 4) || !std::get<0>(cacheTable.get("one")) ||
+        !std::get<0>(cacheTable.get("three")))
+    {
+        std::cout << "Error in get after eviction" << std::endl;
+    }
+    // Updating an existing key in a full table must not evict
+    cacheTable.insert("one", 10);
+    if (evictedKeys.size() != 1)
+    {
+        std::cout << "Error in update of full cache table" << std::endl;
+    }
+    // four is now the least recently used
+    const auto cacheFirst = cacheTable.get_first();
+    if (!(std::get<0>(cacheFirst) && std::get<0>(std::get<1>(cacheFirst)) == "four"))
+    {
+        std::cout << "Error in get_first after eviction" << std::endl;
+    }
+
+
+    // Tests for SIMD hash table //
+
+    // Fill a table with more slots than a single group, then check get, remove and reinsert
+    HashTableSIMD<100> simdTable;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        if (!simdTable.insert("simd" + std::to_string(i), i))
+        {
+            std::cout << "Error in SIMD insert" << std::endl;
+        }
+    }
+    if (simdTable.insert("simd100", 100))
+    {
+        std::cout << "Error in SIMD insert full table" << std::endl;
+    }
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        const auto simdGet = simdTable.get("simd" + std::to_string(i));
+        if (!(std::get<0>(simdGet) && std::get<1>(simdGet) == i))
+        {
+            std::cout << "Error in SIMD get" << std::endl;
+        }
+    }
+    if (!simdTable.remove("simd50") || std::get<0>(simdTable.get("simd50")) || simdTable.remove("simd50"))
+    {
+        std::cout << "Error in SIMD remove" << std::endl;
+    }
+    // The erased slot must be reused
+    if (!simdTable.insert("simd100", 100) || !std::get<0>(simdTable.get("simd100")))
+    {
+        std::cout << "Error in SIMD insert after remove" << std::endl;
+    }
+    const auto simdFirst = simdTable.get_first();
+    if (!(std::get<0>(simdFirst) && std::get<0>(std::get<1>(simdFirst)) == "simd0"))
+    {
+        std::cout << "Error in SIMD get_first" << std::endl;
+    }
+    const auto simdLast = simdTable.get_last();
+    if (!(std::get<0>(simdLast) && std::get<0>(std::get<1>(simdLast)) == "simd100"))
+    {
+        std::cout << "Error in SIMD get_last" << std::endl;
+    }
+
+
+    // Tests for Robin Hood hash table //
+
+    // Churn a small table with removes and inserts, without tombstones every key must stay reachable
+    RobinHoodHashTable<64> robinHoodTable;
+    for (uint32_t round = 0; round < 20; ++round)
+    {
+        for (uint32_t i = 0; i < 48; ++i)
+        {
+            robinHoodTable.insert("rh" + std::to_string(round * 48 + i), i);
+        }
+        for (uint32_t i = 0; i < 48; i += 2)
+        {
+            robinHoodTable.remove("rh" + std::to_string(round * 48 + i));
+        }
+        for (uint32_t i = 1; i < 48; i += 2)
+        {
+            robinHoodTable.remove("rh" + std::to_string(round * 48 + i));
+        }
+    }
+    if (robinHoodTable.size() != 0 || robinHoodTable.max_displacement() != 0 ||
+        robinHoodTable.mean_displacement() != 0.0 || std::get<0>(robinHoodTable.get_first()))
+    {
+        std::cout << "Error in Robin Hood remove" << std::endl;
+    }
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        if (!robinHoodTable.insert("rh" + std::to_string(i), i))
+        {
+            std::cout << "Error in Robin Hood insert" << std::endl;
+        }
+    }
+    if (robinHoodTable.insert("rh64", 64))
+    {
+        std::cout << "Error in Robin Hood insert full table" << std::endl;
+    }
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        const auto robinHoodGet = robinHoodTable.get("rh" + std::to_string(i));
+        if (!(std::get<0>(robinHoodGet) && std::get<1>(robinHoodGet) == i))
+        {
+            std::cout << "Error in Robin Hood get" << std::endl;
+        }
+    }
+    if (robinHoodTable.max_displacement() == 0 || robinHoodTable.mean_displacement() <= 0.0)
+    {
+        std::cout << "Error in Robin Hood displacement" << std::endl;
+    }
+    // Elements are shifted around but the LRU order must stay the same
+    robinHoodTable.remove("rh0");
+    const auto robinHoodFirst = robinHoodTable.get_first();
+    if (!(std::get<0>(robinHoodFirst) && std::get<0>(std::get<1>(robinHoodFirst)) == "rh1"))
+    {
+        std::cout << "Error in Robin Hood get_first" << std::endl;
+    }
+    const auto robinHoodLast = robinHoodTable.get_last();
+    if (!(std::get<0>(robinHoodLast) && std::get<0>(std::get<1>(robinHoodLast)) == "rh63"))
+    {
+        std::cout << "Error in Robin Hood get_last" << std::endl;
+    }
+
+
+    // Tests for upsert and find_or_insert //
+
+    HashTable<5> upsertTable;
+    // Lookups with a char range that is not null terminated
+    const char *upsertText = "alphabeta";
+    const std::string_view alpha(upsertText, 5);
+    const std::string_view beta(upsertText + 5, 4);
+    uint32_t *alphaCount = upsertTable.find_or_insert(alpha);
+    if (alphaCount == nullptr || *alphaCount != 0)
+    {
+        std::cout << "Error in find_or_insert new key" << std::endl;
+    }
+    else
+    {
+        *alphaCount += 5;
+    }
+    // Precomputed hash must give the same slot
+    uint32_t *alphaAgain = upsertTable.find_or_insert(alpha, upsertTable.hashKey("alpha"));
+    if (alphaAgain != alphaCount || *alphaAgain != 5)
+    {
+        std::cout << "Error in find_or_insert existing key" << std::endl;
+    }
+    if (!upsertTable.upsert(beta, 7) || !upsertTable.upsert(beta, 8, upsertTable.hashKey(beta)))
+    {
+        std::cout << "Error in upsert" << std::endl;
+    }
+    const auto betaGet = upsertTable.get("beta");
+    if (!(std::get<0>(betaGet) && std::get<1>(betaGet) == 8) || std::get<0>(upsertTable.get(alpha.substr(0, 3))))
+    {
+        std::cout << "Error in get after upsert" << std::endl;
+    }
+    // A key behind an erased slot must be updated and not inserted a second time
+    HashTable<2> chainTable;
+    chainTable.insert("first", 1);
+    chainTable.insert("second", 2);
+    chainTable.remove("first");
+    chainTable.upsert("second", 3);
+    chainTable.remove("second");
+    if (std::get<0>(chainTable.get("second")) || std::get<0>(chainTable.get_first()))
+    {
+        std::cout << "Error in upsert after erased slot" << std::endl;
+    }
+    // find_or_insert on a full table returns nullptr
+    HashTable<1> probeTable;
+    probeTable.insert("x", 1);
+    if (probeTable.find_or_insert("y") != nullptr || probeTable.find_or_insert("x") == nullptr)
+    {
+        std::cout << "Error in find_or_insert full table" << std::endl;
+    }
+
+
+    // Tests for compact hash table //
+
+    // Mix keys that fit inline with keys that go to the side arena
+    CompactHashTable<5> compactTable;
+    const std::string longKey = "a key that is longer than the inline key buffer";
+    compactTable.insert("short", 1);
+    compactTable.insert(longKey, 2);
+    compactTable.insert("exactly22characterskey", 3);
+    const auto compactLong = compactTable.get(longKey);
+    const auto compactShort = compactTable.get("short");
+    if (!(std::get<0>(compactLong) && std::get<1>(compactLong) == 2) ||
+        !(std::get<0>(compactShort) && std::get<1>(compactShort) == 1))
+    {
+        std::cout << "Error in compact get" << std::endl;
+    }
+    const auto compactFirst = compactTable.get_first();
+    if (!(std::get<0>(compactFirst) && std::get<0>(std::get<1>(compactFirst)) == "exactly22characterskey"))
+    {
+        std::cout << "Error in compact get_first" << std::endl;
+    }
+    const auto compactLast = compactTable.get_last();
+    if (!(std::get<0>(compactLast) && std::get<0>(std::get<1>(compactLast)) == "short"))
+    {
+        std::cout << "Error in compact get_last" << std::endl;
+    }
+    if (!compactTable.remove(longKey) || std::get<0>(compactTable.get(longKey)) || compactTable.size() != 2)
+    {
+        std::cout << "Error in compact remove" << std::endl;
+    }
+    compactTable.insert(longKey + "!", 4);
+    const auto compactLastLong = compactTable.get_last();
+    if (!(std::get<0>(compactLastLong) && std::get<0>(std::get<1>(compactLastLong)) == longKey + "!"))
+    {
+        std::cout << "Error in compact get_last of long key" << std::endl;
+    }
+
+
+    // Tests for sharded hash table //
+
+    // Every thread counts the same keys, the counts must add up without lost updates
+    ShardedHashTable<1024, 8> shardedTable;
+    const uint32_t shardedThreads = 4;
+    const uint32_t shardedKeys = 1000;
+    std::vector<std::thread> shardedWorkers;
+    for (uint32_t t = 0; t < shardedThreads; ++t)
+    {
+        shardedWorkers.emplace_back([&shardedTable]() {
+            for (uint32_t i = 0; i < shardedKeys; ++i)
+            {
+                if (!shardedTable.add("shard" + std::to_string(i), 1))
+                {
+                    std::cout << "Error in sharded add" << std::endl;
+                }
+            }
+        });
+    }
+    for (auto &worker : shardedWorkers)
+    {
+        worker.join();
+    }
+    for (uint32_t i = 0; i < shardedKeys; ++i)
+    {
+        const auto shardedGet = shardedTable.get("shard" + std::to_string(i));
+        if (!(std::get<0>(shardedGet) && std::get<1>(shardedGet) == shardedThreads))
+        {
+            std::cout << "Error in sharded get" << std::endl;
+        }
+    }
+    if (!shardedTable.remove("shard0") || std::get<0>(shardedTable.get("shard0")))
+    {
+        std::cout << "Error in sharded remove" << std::endl;
+    }
+    ShardedHashTable<4, 4> emptyShardedTable;
+    if (std::get<0>(emptyShardedTable.get_first()) || std::get<0>(emptyShardedTable.get_last()))
+    {
+        std::cout << "Error in sharded get_first on empty table" << std::endl;
+    }
+    emptyShardedTable.insert("only", 1);
+    const auto shardedFirst = emptyShardedTable.get_first();
+    if (!(std::get<0>(shardedFirst) && std::get<0>(std::get<1>(shardedFirst)) == "only"))
+    {
+        std::cout << "Error in sharded get_first" << std::endl;
+    }
+
+
+    // Tests for Clock recency policy and peek //
+
+    HashTableOptions clockOptions;
+    clockOptions.capacityPolicy = CapacityPolicy::EvictLeastRecentlyUsed;
+    clockOptions.recencyPolicy = RecencyPolicy::Clock;
+    HashTable<3> clockTable(clockOptions);
+    clockTable.insert("one", 1);
+    clockTable.insert("two", 2);
+    clockTable.insert("three", 3);
+    // A hit only marks one as referenced, so two is the next to be evicted
+    clockTable.get("one");
+    const auto clockFirst = clockTable.get_first();
+    if (!(std::get<0>(clockFirst) && std::get<0>(std::get<1>(clockFirst)) == "two"))
+    {
+        std::cout << "Error in Clock get_first" << std::endl;
+    }
+    clockTable.insert("four", 4);
+    if (std::get<0>(clockTable.peek("two")) || !std::get<0>(clockTable.peek("one")))
+    {
+        std::cout << "Error in Clock eviction" << std::endl;
+    }
+    // one got its second chance and three was never referenced
+    const auto clockNext = clockTable.get_first();
+    if (!(std::get<0>(clockNext) && std::get<0>(std::get<1>(clockNext)) == "three"))
+    {
+        std::cout << "Error in Clock second chance" << std::endl;
+    }
+    // peek must not change the order in the exact policy either
+    HashTable<3> peekTable;
+    peekTable.insert("one", 1);
+    peekTable.insert("two", 2);
+    const auto peekOne = peekTable.peek("one");
+    const auto peekFirst = peekTable.get_first();
+    if (!(std::get<0>(peekOne) && std::get<1>(peekOne) == 1) ||
+        !(std::get<0>(peekFirst) && std::get<0>(std::get<1>(peekFirst)) == "one"))
+    {
+        std::cout << "Error in peek" << std::endl;
+    }
+
+
+    // Tests for generic keys, values and hashers //
+
+    // Integer keys with a power of two size
+    HashTable<8, uint64_t, double> tradeTable;
+    for (uint64_t tradeId = 1000000000000ULL; tradeId < 1000000000008ULL; ++tradeId)
+    {
+        tradeTable.insert(tradeId, static_cast<double>(tradeId % 100) / 4.0);
+    }
+    const auto tradeGet = tradeTable.get(1000000000006ULL);
+    if (!(std::get<0>(tradeGet) && std::get<1>(tradeGet) == 1.5) || tradeTable.insert(1ULL, 0.0))
+    {
+        std::cout << "Error in integer key table" << std::endl;
+    }
+    tradeTable.remove(1000000000000ULL);
+    const auto tradeFirst = tradeTable.get_first();
+    if (!(std::get<0>(tradeFirst) && std::get<0>(std::get<1>(tradeFirst)) == 1000000000001ULL))
+    {
+        std::cout << "Error in integer key get_first" << std::endl;
+    }
+    // A custom hasher that sends every key to the same slot must still work through probing
+    struct ConstantHasher
+    {
+        size_t operator()(std::string_view) const
+        {
+            return 7;
+        }
+    };
+    HashTable<6, std::string, uint32_t, ConstantHasher> collisionTable;
+    collisionTable.insert("a", 1);
+    collisionTable.insert("b", 2);
+    collisionTable.insert("c", 3);
+    collisionTable.remove("b");
+    const auto collisionGet = collisionTable.get("c");
+    if (!(std::get<0>(collisionGet) && std::get<1>(collisionGet) == 3) || std::get<0>(collisionTable.get("b")))
+    {
+        std::cout << "Error in custom hasher table" << std::endl;
+    }
+
+
+    // Tests for batched get and insert //
+
+    // A batch must give the same results and the same LRU order as sequential calls
+    HashTable<64> batchTable;
+    HashTable<64> sequentialTable;
+    std::vector<std::string> batchKeyStorage;
+    for (uint32_t i = 0; i < 70; ++i)
+    {
+        // Some keys repeat inside the batch
+        batchKeyStorage.push_back("batch" + std::to_string(i % 50));
+    }
+    std::vector<std::string_view> batchKeys(batchKeyStorage.begin(), batchKeyStorage.end());
+    std::vector<uint32_t> batchValues;
+    for (uint32_t i = 0; i < batchKeys.size(); ++i)
+    {
+        batchValues.push_back(i);
+        sequentialTable.insert(batchKeys[i], i);
+    }
+    if (batchTable.insert_batch(batchKeys, batchValues) != batchKeys.size())
+    {
+        std::cout << "Error in insert_batch" << std::endl;
+    }
+    std::reverse(batchKeys.begin(), batchKeys.end());
+    batchKeys.push_back("missing");
+    std::vector<std::tuple<bool, uint32_t>> batchResults;
+    batchTable.get_batch(batchKeys, batchResults);
+    for (uint32_t i = 0; i < batchKeys.size(); ++i)
+    {
+        if (batchResults[i] != sequentialTable.get(batchKeys[i]))
+        {
+            std::cout << "Error in get_batch" << std::endl;
+        }
+    }
+    if (batchTable.get_first() != sequentialTable.get_first() || batchTable.get_last() != sequentialTable.get_last())
+    {
+        std::cout << "Error in LRU order after batch" << std::endl;
+    }
+
+
+    // Tests for word tokenizer //
+
+    // Words across 32 byte blocks, every kind of whitespace and a word at the very end
+    std::string tokenizerText = "  first\tsecond\nthird\r\n\v\fa-word-that-is-longer-than-one-block-of-32-bytes ";
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        tokenizerText += "w" + std::to_string(i) + (i % 3 == 0 ? "\n" : " ");
+    }
+    tokenizerText += "last";
+    std::vector<std::string> expectedWords;
+    std::istringstream tokenizerStream(tokenizerText);
+    std::string expectedWord;
+    while (tokenizerStream >> expectedWord)
+    {
+        expectedWords.push_back(expectedWord);
+    }
+    std::vector<std::string> tokenizedWords;
+    const size_t tokenizedCount = WordTokenizer::tokenize(
+        tokenizerText, [&tokenizedWords](std::string_view word) { tokenizedWords.emplace_back(word); });
+    if (tokenizedCount != expectedWords.size() || tokenizedWords != expectedWords)
+    {
+        std::cout << "Error in tokenize" << std::endl;
+    }
+    if (WordTokenizer::tokenize("", [](std::string_view) {}) != 0 ||
+        WordTokenizer::tokenize(" \n\t ", [](std::string_view) {}) != 0)
+    {
+        std::cout << "Error in tokenize of empty text" << std::endl;
+    }
+    // The same words from a memory mapped file
+    const std::string tokenizerPath = "part1_tokenizer_test.txt";
+    {
+        std::ofstream tokenizerFile(tokenizerPath);
+        tokenizerFile << tokenizerText;
+    }
+    {
+        MappedFile tokenizerMapped(tokenizerPath);
+        std::vector<std::string> mappedWords;
+        WordTokenizer::tokenize(tokenizerMapped.contents(),
+                                [&mappedWords](std::string_view word) { mappedWords.emplace_back(word); });
+        if (!tokenizerMapped.isOpen() || mappedWords != expectedWords)
+        {
+            std::cout << "Error in tokenize of mapped file" << std::endl;
+        }
+    }
+    std::remove(tokenizerPath.c_str());
+    if (MappedFile("part1_file_that_does_not_exist.txt").isOpen())
+    {
+        std::cout << "Error in mapping missing file" << std::endl;
+    }
+
+
+    // Tests for merge and parallel word count //
+
+    HashTable<8> mergeTarget;
+    HashTable<8> mergeSource;
+    mergeTarget.insert("a", 1);
+    mergeTarget.insert("b", 2);
+    mergeSource.insert("c", 30);
+    mergeSource.insert("a", 10);
+    const auto add = [](const uint32_t x, const uint32_t y) { return x + y; };
+    const bool merged = mergeTarget.merge(mergeSource, add);
+    const auto mergedA = mergeTarget.peek("a");
+    const auto mergedC = mergeTarget.peek("c");
+    if (!merged || !(std::get<0>(mergedA) && std::get<1>(mergedA) == 11) ||
+        !(std::get<0>(mergedC) && std::get<1>(mergedC) == 30))
+    {
+        std::cout << "Error in merge" << std::endl;
+    }
+    // Merged keys keep the order they had in the source and come after the rest
+    const auto mergedFirst = mergeTarget.get_first();
+    const auto mergedLast = mergeTarget.get_last();
+    if (!(std::get<0>(mergedFirst) && std::get<0>(std::get<1>(mergedFirst)) == "b") ||
+        !(std::get<0>(mergedLast) && std::get<0>(std::get<1>(mergedLast)) == "a"))
+    {
+        std::cout << "Error in LRU order after merge" << std::endl;
+    }
+    // Merging a table into itself is refused and leaves it unchanged
+    const bool mergedSelf = mergeTarget.merge(mergeTarget, add);
+    const auto selfMergedA = mergeTarget.peek("a");
+    const auto selfMergedFirst = mergeTarget.get_first();
+    if (mergedSelf || std::get<1>(selfMergedA) != 11 || std::get<0>(std::get<1>(selfMergedFirst)) != "b")
+    {
+        std::cout << "Error in merge of a table into itself" << std::endl;
+    }
+
+    // Counting with several threads must give the same counts and LRU order as one thread
+    std::string countText;
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        countText += "word" + std::to_string((i * 7919) % 613) + (i % 11 == 0 ? "\n" : " ");
+    }
+    HashTable<1024> sequentialCount;
+    HashTable<1024> parallelCount;
+    const size_t sequentialWords = WordTokenizer::tokenize(
+        countText, [&sequentialCount](std::string_view word) { ++(*sequentialCount.find_or_insert(word)); });
+    size_t parallelWords = 0;
+    if (!countWordsParallel(countText, 4, parallelCount, &parallelWords) || parallelWords != sequentialWords)
+    {
+        std::cout << "Error in parallel word count" << std::endl;
+    }
+    // Compare by taking the least recently used element from both until they are empty
+    while (std::get<0>(sequentialCount.get_first()))
+    {
+        const auto sequentialFirst = sequentialCount.get_first();
+        const auto parallelFirst = parallelCount.get_first();
+        if (sequentialFirst != parallelFirst)
+        {
+            std::cout << "Error in parallel word count order" << std::endl;
+            break;
+        }
+        sequentialCount.remove(std::get<0>(std::get<1>(sequentialFirst)));
+        parallelCount.remove(std::get<0>(std::get<1>(parallelFirst)));
+    }
+    if (std::get<0>(parallelCount.get_first()))
+    {
+        std::cout << "Error in parallel word count size" << std::endl;
+    }
+
+
+    // Tests for snapshots //
+
+    HashTable<16> snapshotSource;
+    for (const char *key : {"a", "b", "c", "d", "e", "f"})
+    {
+        snapshotSource.insert(key, static_cast<uint32_t>(key[0]));
+    }
+    snapshotSource.remove("c");
+    snapshotSource.get("a");
+    const std::string snapshotPath = "part1_snapshot_test.bin";
+    if (!snapshotSource.save(snapshotPath))
+    {
+        std::cout << "Error in snapshot save" << std::endl;
+    }
+    {
+        // Lookups straight from the mapped file
+        const HashTableSnapshot<HashTable<16>> snapshotView(snapshotPath);
+        const auto viewA = snapshotView.get("a");
+        const auto viewLast = snapshotView.get_last();
+        const auto viewFirst = snapshotView.get_first();
+        if (!snapshotView.matchesLayout() || snapshotView.size() != 5 ||
+            !(std::get<0>(viewA) && std::get<1>(viewA) == 'a') || std::get<0>(snapshotView.get("c")) ||
+            std::get<0>(viewLast) == false || std::get<0>(std::get<1>(viewLast)) != "a" ||
+            std::get<0>(viewFirst) == false || std::get<0>(std::get<1>(viewFirst)) != "b")
+        {
+            std::cout << "Error in snapshot view" << std::endl;
+        }
+    }
+    // Same Size copies the slots, a different Size inserts the elements again, both keep the LRU order
+    HashTable<16> snapshotSameSize;
+    HashTable<64> snapshotOtherSize;
+    if (!snapshotSameSize.load(snapshotPath) || !snapshotOtherSize.load(snapshotPath))
+    {
+        std::cout << "Error in snapshot load" << std::endl;
+    }
+    while (std::get<0>(snapshotSource.get_first()))
+    {
+        const auto sourceFirst = snapshotSource.get_first();
+        if (snapshotSameSize.get_first() != sourceFirst || snapshotOtherSize.get_first() != sourceFirst)
+        {
+            std::cout << "Error in LRU order after snapshot load" << std::endl;
+            break;
+        }
+        const std::string &sourceKey = std::get<0>(std::get<1>(sourceFirst));
+        snapshotSource.remove(sourceKey);
+        snapshotSameSize.remove(sourceKey);
+        snapshotOtherSize.remove(sourceKey);
+    }
+    if (std::get<0>(snapshotSameSize.get_first()) || std::get<0>(snapshotOtherSize.get_first()))
+    {
+        std::cout << "Error in snapshot load size" << std::endl;
+    }
+    // Integer keys are stored as raw bytes
+    HashTable<8, uint64_t, double> snapshotNumbers;
+    snapshotNumbers.insert(42, 0.5);
+    snapshotNumbers.insert(7, 1.5);
+    HashTable<8, uint64_t, double> snapshotNumbersLoaded;
+    const auto loadedNumber = snapshotNumbers.save(snapshotPath) && snapshotNumbersLoaded.load(snapshotPath)
+                                  ? snapshotNumbersLoaded.peek(42)
+                                  : std::make_tuple(false, 0.0);
+    if (!(std::get<0>(loadedNumber) && std::get<1>(loadedNumber) == 0.5) ||
+        std::get<0>(std::get<1>(snapshotNumbersLoaded.get_last())) != 7)
+    {
+        std::cout << "Error in snapshot of integer keys" << std::endl;
+    }
+    // A snapshot of other key or value types, or a missing file, is rejected
+    if (snapshotSameSize.load(snapshotPath) || snapshotSameSize.load("part1_file_that_does_not_exist.bin"))
+    {
+        std::cout << "Error in loading invalid snapshot" << std::endl;
+    }
+    // An occupied slot that is not on the LRU/MRU list and whose key lies outside the key pool is rejected before
+    // its key is read
+    std::string damagedSnapshot;
+    if (snapshotNumbers.save(snapshotPath))
+    {
+        std::ifstream damagedInput(snapshotPath, std::ios::binary);
+        damagedSnapshot.assign(std::istreambuf_iterator<char>(damagedInput), std::istreambuf_iterator<char>());
+    }
+    using NumberSlot = snapshot::Slot<double>;
+    for (uint32_t index = 0; index < 8 && damagedSnapshot.size() >= sizeof(snapshot::Header) + 8 * sizeof(NumberSlot);
+         ++index)
+    {
+        char *slotBytes = damagedSnapshot.data() + sizeof(snapshot::Header) + index * sizeof(NumberSlot);
+        NumberSlot damagedSlot{};
+        std::memcpy(&damagedSlot, slotBytes, sizeof(damagedSlot));
+        if (damagedSlot.state == snapshot::SlotState::Unused)
+        {
+            damagedSlot.state = snapshot::SlotState::Occupied;
+            damagedSlot.keyOffset = 1U << 20;
+            damagedSlot.keyLength = 4096;
+            damagedSlot.moreRecent = snapshot::NoSlot;
+            damagedSlot.lessRecent = snapshot::NoSlot;
+            std::memcpy(slotBytes, &damagedSlot, sizeof(damagedSlot));
+            break;
+        }
+    }
+    std::ofstream(snapshotPath, std::ios::binary | std::ios::trunc) << damagedSnapshot;
+    if (damagedSnapshot.empty() || snapshotNumbersLoaded.load(snapshotPath) ||
+        std::get<0>(snapshotNumbersLoaded.get_first()))
+    {
+        std::cout << "Error in loading a snapshot with an unlisted occupied slot" << std::endl;
+    }
+    std::remove(snapshotPath.c_str());
+
+
+    // Tests for ordered traversal and top k //
+
+    HashTable<16> orderTable;
+    orderTable.insert("x", 5);
+    orderTable.insert("y", 9);
+    orderTable.insert("z", 1);
+    orderTable.insert("w", 9);
+    orderTable.get("x");
+    std::vector<std::string> mruKeys;
+    for (const auto &[key, value] : orderTable.mru_order())
+    {
+        mruKeys.push_back(key);
+    }
+    std::vector<std::string> lruKeys;
+    for (const auto &[key, value] : orderTable.lru_order())
+    {
+        lruKeys.push_back(key);
+    }
+    if (mruKeys != std::vector<std::string>{"x", "w", "z", "y"} ||
+        lruKeys != std::vector<std::string>{"y", "z", "w", "x"})
+    {
+        std::cout << "Error in recency order traversal" << std::endl;
+    }
+    // Walking the list does not promote elements
+    if (std::get<0>(std::get<1>(orderTable.get_first())) != "y")
+    {
+        std::cout << "Error in traversal changing the LRU order" << std::endl;
+    }
+    HashTable<16> emptyOrderTable;
+    if (emptyOrderTable.mru_order().begin() != emptyOrderTable.mru_order().end() ||
+        !emptyOrderTable.top_k_by_value(3).empty())
+    {
+        std::cout << "Error in traversal of empty table" << std::endl;
+    }
+    const auto topTwo = orderTable.top_k_by_value(2);
+    const auto topAll = orderTable.top_k_by_value(10);
+    if (topTwo.size() != 2 || std::get<1>(topTwo[0]) != 9 || std::get<1>(topTwo[1]) != 9 || topAll.size() != 4 ||
+        std::get<0>(topAll[2]) != "x" || std::get<0>(topAll[3]) != "z" || !orderTable.top_k_by_value(0).empty())
+    {
+        std::cout << "Error in top_k_by_value" << std::endl;
+    }
+    // Smallest values first with another comparison
+    const auto bottomOne = orderTable.top_k_by_value(1, std::greater<uint32_t>());
+    if (bottomOne.size() != 1 || std::get<0>(bottomOne[0]) != "z")
+    {
+        std::cout << "Error in top_k_by_value with comparison" << std::endl;
+    }
+
+
+    // Tests for statistics //
+
+    HashTable<8, std::string, uint32_t, DefaultHasher<std::string>, HashTableStats> statsTable;
+    statsTable.insert("a", 1);
+    statsTable.insert("b", 2);
+    statsTable.insert("c", 3);
+    statsTable.get("a");
+    statsTable.get("zz");
+    statsTable.peek("c");
+    statsTable.remove("b");
+    statsTable.insert("d", 4);
+    const HashTableStats &tableStats = statsTable.statistics();
+    uint64_t histogramTotal = 0;
+    for (const uint64_t count : tableStats.probeLengths)
+    {
+        histogramTotal += count;
+    }
+    if (tableStats.hits != 2 || tableStats.misses != 1 || tableStats.inserts != 4 || tableStats.removes != 1 ||
+        tableStats.occupied != 3 || tableStats.tombstones + tableStats.tombstoneReuses != 1 ||
+        tableStats.relinks != 1 || tableStats.probes != histogramTotal || tableStats.loadFactor() != 3.0 / 8.0)
+    {
+        std::cout << "Error in hash table statistics" << std::endl;
+    }
+    if (tableStats.toJson().rfind("{\"capacity\":8,\"occupied\":3,", 0) != 0 ||
+        tableStats.toText().find("hits: 2\n") == std::string::npos)
+    {
+        std::cout << "Error in hash table statistics output" << std::endl;
+    }
+    // Evictions and rejected inserts of a full table
+    HashTable<2, std::string, uint32_t, DefaultHasher<std::string>, HashTableStats> statsCache(
+        HashTableOptions{CapacityPolicy::EvictLeastRecentlyUsed, RecencyPolicy::Exact});
+    HashTable<2, std::string, uint32_t, DefaultHasher<std::string>, HashTableStats> statsFull;
+    for (const char *key : {"a", "b", "c"})
+    {
+        statsCache.insert(key, 1);
+        statsFull.insert(key, 1);
+    }
+    if (statsCache.statistics().evictions != 1 || statsCache.statistics().occupied != 2 ||
+        statsFull.statistics().rejected != 1 || statsFull.statistics().occupied != 2)
+    {
+        std::cout << "Error in eviction statistics" << std::endl;
+    }
+
+
+    // Tests for the frequency admission filter //
+
+    FrequencySketch sketch(64);
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        sketch.increment(12345);
+    }
+    if (sketch.estimate(12345) != FrequencySketch::MaxCount || sketch.estimate(54321) > 1)
+    {
+        std::cout << "Error in frequency sketch estimate" << std::endl;
+    }
+    // Aging halves the counters after 10 increments per slot
+    for (uint32_t i = 0; i < 64 * FrequencySketch::SamplesPerSlot; ++i)
+    {
+        sketch.increment(1000000 + i);
+    }
+    if (sketch.estimate(12345) > FrequencySketch::MaxCount / 2)
+    {
+        std::cout << "Error in frequency sketch aging" << std::endl;
+    }
+
+    // A scan of keys used once does not flush the keys used often
+    const HashTableOptions filteredOptions{CapacityPolicy::EvictLeastRecentlyUsed, RecencyPolicy::Exact,
+                                           AdmissionPolicy::FrequencyFilter};
+    HashTable<64> filteredCache(filteredOptions);
+    HashTable<64> unfilteredCache(HashTableOptions{CapacityPolicy::EvictLeastRecentlyUsed, RecencyPolicy::Exact});
+    for (uint32_t hot = 0; hot < 64; ++hot)
+    {
+        const std::string hotKey = "hot" + std::to_string(hot);
+        filteredCache.insert(hotKey, 1);
+        unfilteredCache.insert(hotKey, 1);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            filteredCache.get(hotKey);
+            unfilteredCache.get(hotKey);
+        }
+    }
+    uint32_t admittedScanKeys = 0;
+    uint32_t filteredHotKeys = 0;
+    uint32_t unfilteredHotKeys = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        const std::string scanKey = "scan" + std::to_string(i);
+        admittedScanKeys += filteredCache.insert(scanKey, 1) ? 1 : 0;
+        unfilteredCache.insert(scanKey, 1);
+    }
+    for (uint32_t hot = 0; hot < 64; ++hot)
+    {
+        filteredHotKeys += std::get<0>(filteredCache.peek("hot" + std::to_string(hot))) ? 1 : 0;
+        unfilteredHotKeys += std::get<0>(unfilteredCache.peek("hot" + std::to_string(hot))) ? 1 : 0;
+    }
+    // The sketch is approximate, allow a few scan keys that share counters with frequent keys
+    if (admittedScanKeys > 4 || filteredHotKeys + admittedScanKeys != 64 || unfilteredHotKeys != 0)
+    {
+        std::cout << "Error in frequency admission of a scan" << std::endl;
+    }
+    // A key that becomes frequent is admitted and evicts the least recently used key
+    const auto filteredVictim = filteredCache.get_first();
+    bool frequentAdmitted = false;
+    for (uint32_t i = 0; i < 10 && !frequentAdmitted; ++i)
+    {
+        frequentAdmitted = filteredCache.insert("frequent", 1);
+    }
+    if (!frequentAdmitted || std::get<0>(filteredCache.peek(std::get<0>(std::get<1>(filteredVictim)))) ||
+        !std::get<0>(filteredCache.peek("frequent")))
+    {
+        std::cout << "Error in frequency admission of a frequent key" << std::endl;
+    }
+
+
+    // Tests for TTL expiry //
+
+    uint64_t fakeNow = 1000;
+    HashTableOptions ttlOptions;
+    ttlOptions.ttlClock = [&fakeNow]() { return fakeNow; };
+    HashTable<64, std::string, uint32_t, DefaultHasher<std::string>, HashTableStats> ttlTable(ttlOptions);
+    ttlTable.insert("quote", 1, std::chrono::milliseconds(100));
+    ttlTable.insert("trade", 2, std::chrono::milliseconds(5000));
+    ttlTable.insert("static", 3);
+    fakeNow += 99;
+    if (!std::get<0>(ttlTable.get("quote")))
+    {
+        std::cout << "Error in TTL expiring too early" << std::endl;
+    }
+    fakeNow += 1;
+    if (std::get<0>(ttlTable.peek("quote")) || std::get<0>(ttlTable.get("quote")) ||
+        ttlTable.statistics().expirations != 1)
+    {
+        std::cout << "Error in TTL expiry" << std::endl;
+    }
+    // A long jump expires the rest without touching the element without a TTL
+    fakeNow += 10000000;
+    if (std::get<0>(ttlTable.get("trade")) || !std::get<0>(ttlTable.get("static")) ||
+        ttlTable.statistics().expirations != 2 || ttlTable.statistics().occupied != 1)
+    {
+        std::cout << "Error in TTL expiry after a long time" << std::endl;
+    }
+    // A new TTL replaces the old one and a removed key does not expire again
+    ttlTable.insert("quote", 5, std::chrono::milliseconds(50));
+    ttlTable.insert("quote", 6, std::chrono::milliseconds(200));
+    ttlTable.insert("removed", 7, std::chrono::milliseconds(10));
+    ttlTable.remove("removed");
+    fakeNow += 100;
+    ttlTable.expire();
+    const auto renewedQuote = ttlTable.peek("quote");
+    if (!(std::get<0>(renewedQuote) && std::get<1>(renewedQuote) == 6) || ttlTable.statistics().expirations != 2)
+    {
+        std::cout << "Error in TTL renewal" << std::endl;
+    }
+    // TTLs beyond the range of the timing wheel
+    ttlTable.insert("far", 8, std::chrono::milliseconds(20000000));
+    fakeNow += 19999999;
+    ttlTable.expire();
+    const bool farPresent = std::get<0>(ttlTable.peek("far"));
+    fakeNow += 1;
+    ttlTable.expire();
+    if (!farPresent || std::get<0>(ttlTable.peek("far")))
+    {
+        std::cout << "Error in TTL beyond the timing wheel range" << std::endl;
+    }
+    // Expired elements that were not removed yet are hidden from get_first, get_last, the iterators and top k
+    // like from peek, and merge skips them and carries the remaining TTL of the others over
+    HashTable<16> ttlOrderTable(ttlOptions);
+    ttlOrderTable.insert("old", 1, std::chrono::milliseconds(10));
+    ttlOrderTable.insert("kept", 2, std::chrono::milliseconds(1000));
+    ttlOrderTable.insert("new", 3, std::chrono::milliseconds(10));
+    fakeNow += 20;
+    std::vector<std::string> ttlOrderKeys;
+    for (const auto &[key, value] : ttlOrderTable.lru_order())
+    {
+        ttlOrderKeys.push_back(key);
+    }
+    const std::vector<HashTable<16>::KeyValuePair> ttlTopK = ttlOrderTable.top_k_by_value(3);
+    if (ttlOrderKeys != std::vector<std::string>{"kept"} ||
+        std::get<0>(std::get<1>(ttlOrderTable.get_first())) != "kept" ||
+        std::get<0>(std::get<1>(ttlOrderTable.get_last())) != "kept" || ttlTopK.size() != 1 ||
+        std::get<0>(ttlTopK[0]) != "kept")
+    {
+        std::cout << "Error in LRU order with expired elements" << std::endl;
+    }
+    // A snapshot leaves out the expired elements and the loaded elements have no TTL
+    const std::string ttlSnapshotPath = "part1_ttl_snapshot_test.bin";
+    HashTable<16> ttlLoaded;
+    const bool ttlSnapshotLoaded = ttlOrderTable.save(ttlSnapshotPath) && ttlLoaded.load(ttlSnapshotPath);
+    std::remove(ttlSnapshotPath.c_str());
+    std::vector<std::string> ttlLoadedKeys;
+    for (const auto &[key, value] : ttlLoaded.lru_order())
+    {
+        ttlLoadedKeys.push_back(key);
+    }
+    if (!ttlSnapshotLoaded || ttlLoadedKeys != std::vector<std::string>{"kept"} || std::get<0>(ttlLoaded.peek("old")))
+    {
+        std::cout << "Error in snapshot of a table with TTLs" << std::endl;
+    }
+    HashTable<16> ttlMergeTarget(ttlOptions);
+    ttlMergeTarget.insert("kept", 10);
+    ttlMergeTarget.insert("plain", 20);
+    const bool ttlMerged = ttlMergeTarget.merge(ttlOrderTable, add);
+    const auto ttlMergedKept = ttlMergeTarget.peek("kept");
+    const bool ttlMergedExpired = std::get<0>(ttlMergeTarget.peek("old")) || std::get<0>(ttlMergeTarget.peek("new"));
+    fakeNow += 990;
+    ttlMergeTarget.expire();
+    if (!ttlMerged || std::get<1>(ttlMergedKept) != 12 || ttlMergedExpired ||
+        std::get<0>(ttlMergeTarget.peek("kept")) || !std::get<0>(ttlMergeTarget.peek("plain")))
+    {
+        std::cout << "Error in merge of a table with TTLs" << std::endl;
+    }
+
+
+    // Tests for the shared memory Hash Table //
+
+    const std::string sharedName = "/part1_shared_hash_table_test";
+    SharedHashTable<64> sharedWriter(sharedName);
+    SharedHashTable<64> sharedReader(sharedName, SegmentAccess::ReadOnly);
+    sharedWriter.insert("bid", 10);
+    sharedWriter.insert("ask", 11);
+    sharedWriter.insert("last", 12);
+    sharedWriter.get("bid");
+    const auto sharedAsk = sharedReader.get("ask");
+    const auto sharedLast = sharedReader.get_last();
+    const auto sharedFirst = sharedReader.get_first();
+    if (!sharedWriter.isWriter() || !sharedReader.isOpen() || sharedReader.isWriter() || sharedReader.size() != 3 ||
+        !(std::get<0>(sharedAsk) && std::get<1>(sharedAsk) == 11) ||
+        std::get<0>(std::get<1>(sharedLast)) != "bid" || std::get<0>(std::get<1>(sharedFirst)) != "ask")
+    {
+        std::cout << "Error in shared memory Hash Table reader" << std::endl;
+    }
+    // Readers cannot change the table and their lookups do not change the order
+    if (sharedReader.insert("mid", 13) || sharedReader.remove("bid") ||
+        std::get<0>(std::get<1>(sharedReader.get_first())) != "ask")
+    {
+        std::cout << "Error in shared memory Hash Table read only access" << std::endl;
+    }
+    // A reader in another process
+    const pid_t sharedChild = ::fork();
+    if (sharedChild == 0)
+    {
+        SharedHashTable<64> childReader(sharedName, SegmentAccess::ReadOnly);
+        const auto childLast = childReader.get("last");
+        ::_exit(std::get<0>(childLast) && std::get<1>(childLast) == 12 && childReader.size() == 3 ? 0 : 1);
+    }
+    int sharedChildStatus = -1;
+    ::waitpid(sharedChild, &sharedChildStatus, 0);
+    if (sharedChild < 0 || !WIFEXITED(sharedChildStatus) || WEXITSTATUS(sharedChildStatus) != 0)
+    {
+        std::cout << "Error in shared memory Hash Table across processes" << std::endl;
+    }
+    SharedMemorySegment::remove(sharedName);
+
+    // A small arena in a memfd is compacted when removed keys leave no room at its end
+    const int sharedFd = ::memfd_create("part1_shared_hash_table_test", 0);
+    SharedHashTable<16> arenaWriter(sharedFd, 24);
+    SharedHashTable<16> arenaReader(sharedFd, SegmentAccess::ReadOnly);
+    arenaWriter.insert("aaaaaaaa", 1);
+    arenaWriter.insert("bbbbbbbb", 2);
+    arenaWriter.insert("cccccccc", 3);
+    const bool arenaFull = !arenaWriter.insert("dddddddd", 4);
+    arenaWriter.remove("bbbbbbbb");
+    const bool arenaCompacted = arenaWriter.insert("dddddddd", 4);
+    if (!arenaFull || !arenaCompacted || std::get<1>(arenaReader.get("aaaaaaaa")) != 1 ||
+        std::get<1>(arenaReader.get("cccccccc")) != 3 || std::get<1>(arenaReader.get("dddddddd")) != 4 ||
+        std::get<0>(arenaReader.get("bbbbbbbb")))
+    {
+        std::cout << "Error in shared memory Hash Table key arena" << std::endl;
+    }
+    ::close(sharedFd);
+
+    // A writer that dies in the middle of a change leaves the sequence counter odd, here with a wrong element
+    // count. Readers give up instead of waiting forever and the next writer repairs the segment.
+    const int crashedFd = ::memfd_create("part1_shared_hash_table_crash_test", 0);
+    SharedHashTable<16> crashedWriter(crashedFd, 64);
+    crashedWriter.insert("open", 1);
+    crashedWriter.insert("close", 2);
+    // Offsets of elementCount and sequence in the segment header
+    const uint32_t crashedCount = 7;
+    const uint64_t crashedSequence = 1;
+    const bool crashWritten =
+        ::pwrite(crashedFd, &crashedCount, sizeof(crashedCount), 20) == sizeof(crashedCount) &&
+        ::pwrite(crashedFd, &crashedSequence, sizeof(crashedSequence), 48) == sizeof(crashedSequence);
+    SharedHashTable<16> stalledReader(crashedFd, SegmentAccess::ReadOnly);
+    const bool readerGaveUp = !std::get<0>(stalledReader.get("open")) && stalledReader.size() == 0 &&
+                              !std::get<0>(stalledReader.get_last());
+    SharedHashTable<16> restartedWriter(crashedFd, SegmentAccess::ReadWrite);
+    const auto recoveredOpen = stalledReader.get("open");
+    if (!crashWritten || !readerGaveUp || !restartedWriter.isWriter() || stalledReader.size() != 2 ||
+        !(std::get<0>(recoveredOpen) && std::get<1>(recoveredOpen) == 1) || !restartedWriter.insert("high", 3) ||
+        !restartedWriter.remove("close") || std::get<0>(stalledReader.get("close")) || stalledReader.size() != 2)
+    {
+        std::cout << "Error in shared memory Hash Table after a writer crash" << std::endl;
+    }
+    ::close(crashedFd);
+
+    // A reader running while the writer updates never sees a value of another key
+    SharedHashTable<256> concurrentWriter(sharedName);
+    SharedHashTable<256> concurrentReader(sharedName, SegmentAccess::ReadOnly);
+    constexpr uint32_t SharedKeyCount = 100;
+    std::atomic<bool> writerDone{false};
+    bool concurrentMismatch = false;
+    std::thread sharedReaderThread([&]() {
+        while (!writerDone.load())
+        {
+            for (uint32_t key = 0; key < SharedKeyCount; ++key)
+            {
+                const auto result = concurrentReader.get("key" + std::to_string(key));
+                concurrentMismatch |= std::get<0>(result) && std::get<1>(result) % SharedKeyCount != key;
+            }
+        }
+    });
+    for (uint32_t i = 0; i < 200000; ++i)
+    {
+        const uint32_t key = i % SharedKeyCount;
+        if (i % 7 == 0)
+        {
+            concurrentWriter.remove("key" + std::to_string(key));
+        }
+        else
+        {
+            concurrentWriter.insert("key" + std::to_string(key), i);
+        }
+    }
+    writerDone.store(true);
+    sharedReaderThread.join();
+    if (concurrentMismatch)
+    {
+        std::cout << "Error in shared memory Hash Table concurrent reads" << std::endl;
+    }
+    SharedMemorySegment::remove(sharedName);
+
+
+    // Tests for huge page backed slot arrays //
+
+    // Large enough for huge pages, the kernel may not have any so every policy may fall back
+    HashTableOptions hugePageOptions;
+    hugePageOptions.pagePolicy = PagePolicy::TransparentHugePages;
+    hugePageOptions.prefault = true;
+    HashTable<1U << 16> hugePageTable(hugePageOptions);
+    hugePageOptions.pagePolicy = PagePolicy::ExplicitHugePages;
+    HashTable<1U << 16> explicitHugePageTable(hugePageOptions);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        hugePageTable.insert("page" + std::to_string(i), i);
+        explicitHugePageTable.insert("page" + std::to_string(i), i);
+    }
+    const auto hugePageValue = hugePageTable.get("page500");
+    const auto explicitHugePageValue = explicitHugePageTable.get("page999");
+    if (!(std::get<0>(hugePageValue) && std::get<1>(hugePageValue) == 500) ||
+        !(std::get<0>(explicitHugePageValue) && std::get<1>(explicitHugePageValue) == 999) ||
+        hugePageTable.pagePolicy() == PagePolicy::ExplicitHugePages ||
+        std::get<0>(std::get<1>(hugePageTable.get_first())) != "page0")
+    {
+        std::cout << "Error in huge page backed Hash Table" << std::endl;
+    }
+    // A slot array smaller than a huge page keeps normal pages
+    HashTable<64> smallHugePageTable(hugePageOptions);
+    smallHugePageTable.insert("small", 1);
+    if (smallHugePageTable.pagePolicy() != PagePolicy::Default || !std::get<0>(smallHugePageTable.get("small")))
+    {
+        std::cout << "Error in huge page fallback of a small Hash Table" << std::endl;
+    }
+
+
+    // Tests for the byte budget //
+
+    // Default weights are the key length plus the 4 bytes of the value
+    HashTableOptions budgetOptions;
+    budgetOptions.byteBudget = 40;
+    std::vector<std::string> budgetEvicted;
+    HashTable<64> budgetTable(budgetOptions, [&budgetEvicted](const std::string &key, const uint32_t & /*value*/) {
+        budgetEvicted.push_back(key);
+    });
+    budgetTable.insert("alpha", 1);
+    budgetTable.insert("beta", 2);
+    budgetTable.insert("gamma", 3);
+    budgetTable.insert("delta", 4);
+    const uint64_t bytesBeforeEviction = budgetTable.usedBytes();
+    budgetTable.get("alpha");
+    budgetTable.insert("epsilon", 5);
+    if (bytesBeforeEviction != 35 || budgetTable.usedBytes() != 38 ||
+        budgetEvicted != std::vector<std::string>{"beta"} || std::get<0>(budgetTable.get("beta")) ||
+        !std::get<0>(budgetTable.get("alpha")) || std::get<0>(std::get<1>(budgetTable.get_first())) != "gamma")
+    {
+        std::cout << "Error in byte budget eviction" << std::endl;
+    }
+    // A key heavier than the whole budget is rejected without evicting anything or calling the callback for it
+    if (budgetTable.insert(std::string(100, 'x'), 6) || budgetTable.usedBytes() != 38 ||
+        budgetEvicted != std::vector<std::string>{"beta"})
+    {
+        std::cout << "Error in byte budget of an element heavier than the budget" << std::endl;
+    }
+    budgetTable.remove("gamma");
+    if (budgetTable.usedBytes() != 29)
+    {
+        std::cout << "Error in byte budget after remove" << std::endl;
+    }
+    // A weight function that depends on the value is applied again when the value changes
+    HashTableOptions valueBudgetOptions;
+    valueBudgetOptions.byteBudget = 100;
+    HashTable<64> valueBudgetTable(valueBudgetOptions, nullptr,
+                                   [](std::string_view /*key*/, const uint32_t &value) { return value; });
+    valueBudgetTable.upsert("small", 30);
+    valueBudgetTable.upsert("large", 60);
+    const uint64_t bytesBeforeGrowth = valueBudgetTable.usedBytes();
+    valueBudgetTable.upsert("large", 80);
+    if (bytesBeforeGrowth != 90 || valueBudgetTable.usedBytes() != 80 || std::get<0>(valueBudgetTable.peek("small")) ||
+        std::get<1>(valueBudgetTable.peek("large")) != 80)
+    {
+        std::cout << "Error in byte budget with a weight function" << std::endl;
+    }
+    // In a full cache a rejected heavy key must not evict the least recently used element first
+    HashTableOptions fullBudgetOptions;
+    fullBudgetOptions.byteBudget = 1000;
+    fullBudgetOptions.capacityPolicy = CapacityPolicy::EvictLeastRecentlyUsed;
+    std::vector<std::string> fullBudgetEvicted;
+    HashTable<2> fullBudgetTable(fullBudgetOptions,
+                                 [&fullBudgetEvicted](const std::string &key, const uint32_t & /*value*/) {
+                                     fullBudgetEvicted.push_back(key);
+                                 });
+    fullBudgetTable.insert("one", 1);
+    fullBudgetTable.insert("two", 2);
+    if (fullBudgetTable.insert(std::string(2000, 'x'), 3) || !fullBudgetEvicted.empty() ||
+        !std::get<0>(fullBudgetTable.peek("one")) || !std::get<0>(fullBudgetTable.peek("two")))
+    {
+        std::cout << "Error in byte budget of a heavy key in a full table" << std::endl;
+    }
+
+
+    // Tests for the frozen Hash Table //
+
+    constexpr std::array<std::pair<std::string_view, uint32_t>, 9> FrozenFields = {
+        {{"e", 0}, {"E", 1}, {"s", 2}, {"a", 3}, {"p", 4}, {"q", 5}, {"f", 6}, {"l", 7}, {"T", 8}}};
+    constexpr FrozenHashTable frozenFields(FrozenFields);
+    // Lookups work in constant expressions too
+    static_assert(std::get<1>(frozenFields.get("T")) == 8 && !frozenFields.contains("t"), "Frozen table lookup");
+    constexpr std::array<std::pair<std::string_view, uint32_t>, 36> FrozenWords = {{
+        {"the", 0}, {"of", 1}, {"and", 2}, {"to", 3}, {"in", 4}, {"a", 5}, {"is", 6}, {"that", 7}, {"for", 8},
+        {"it", 9}, {"as", 10}, {"was", 11}, {"with", 12}, {"be", 13}, {"by", 14}, {"on", 15}, {"not", 16},
+        {"he", 17}, {"i", 18}, {"this", 19}, {"are", 20}, {"or", 21}, {"his", 22}, {"from", 23}, {"at", 24},
+        {"which", 25}, {"but", 26}, {"have", 27}, {"an", 28}, {"they", 29}, {"you", 30}, {"were", 31}, {"her",
+        32}, {"she", 33}, {"there", 34}, {"had", 35}}};
+    constexpr FrozenHashTable frozenWords(FrozenWords);
+    bool frozenFound = true;
+    for (const auto &[key, value] : FrozenWords)
+    {
+        const uint32_t *frozenValue = frozenWords.find(key);
+        frozenFound = frozenFound && frozenValue != nullptr && *frozenValue == value;
+    }
+    for (const auto &[key, value] : FrozenFields)
+    {
+        const auto fieldValue = frozenFields.get(key);
+        frozenFound = frozenFound && std::get<0>(fieldValue) && std::get<1>(fieldValue) == value;
+    }
+    if (!frozenFound || frozenWords.contains("") || frozenWords.contains("They") || frozenWords.contains("thee") ||
+        std::get<0>(frozenFields.get("pq")) || frozenWords.size() != FrozenWords.size())
+    {
+        std::cout << "Error in frozen Hash Table" << std::endl;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
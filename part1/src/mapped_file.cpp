@@ -0,0 +1,49 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path, AccessPattern accessPattern)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat fileStat
+    {
+    };
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        return;
+    }
+
+    size = static_cast<size_t>(fileStat.st_size);
+    if (size > 0)
+    {
+        void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            size = 0;
+            ::close(fd);
+            return;
+        }
+        ::madvise(mapped, size, accessPattern == AccessPattern::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        data = static_cast<const char *>(mapped);
+    }
+    // The mapping stays valid after closing the file descriptor
+    ::close(fd);
+    opened = true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+    {
+        ::munmap(const_cast<char *>(data), size);
+    }
+}
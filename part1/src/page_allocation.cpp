@@ -0,0 +1,116 @@
+#include "page_allocation.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+namespace
+{
+size_t roundUp(size_t bytes, size_t multiple)
+{
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+void *mapAnonymous(size_t bytes, int extraFlags)
+{
+    void *mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+}
+
+// Write one byte of every page so the kernel allocates all pages now
+void touchPages(void *memory, size_t bytes)
+{
+    const auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    volatile char *bytesToTouch = static_cast<char *>(memory);
+    for (size_t offset = 0; offset < bytes; offset += pageSize)
+    {
+        bytesToTouch[offset] = 0;
+    }
+}
+
+page_allocation::Allocation allocateExplicitHugePages(size_t bytes, bool prefault)
+{
+    const size_t mappedBytes = roundUp(bytes, page_allocation::HugePageSize);
+    void *memory = mapAnonymous(mappedBytes, MAP_HUGETLB | (prefault ? MAP_POPULATE : 0));
+    return memory == nullptr ? page_allocation::Allocation{}
+                             : page_allocation::Allocation{memory, mappedBytes, PagePolicy::ExplicitHugePages};
+}
+
+page_allocation::Allocation allocateTransparentHugePages(size_t bytes, bool prefault)
+{
+    // Map one extra huge page and unmap the ends so the memory starts at a huge page boundary, otherwise the
+    // first and last parts of the array cannot be huge pages
+    const size_t mappedBytes = roundUp(bytes, page_allocation::HugePageSize);
+    char *reserved = static_cast<char *>(mapAnonymous(mappedBytes + page_allocation::HugePageSize, 0));
+    if (reserved == nullptr)
+    {
+        return page_allocation::Allocation{};
+    }
+    const auto address = reinterpret_cast<uintptr_t>(reserved);
+    char *memory = reserved + (roundUp(address, page_allocation::HugePageSize) - address);
+    if (memory != reserved)
+    {
+        ::munmap(reserved, static_cast<size_t>(memory - reserved));
+    }
+    const size_t tail = page_allocation::HugePageSize - static_cast<size_t>(memory - reserved);
+    if (tail != 0)
+    {
+        ::munmap(memory + mappedBytes, tail);
+    }
+
+    if (::madvise(memory, mappedBytes, MADV_HUGEPAGE) != 0)
+    {
+        // Kernel without transparent huge pages
+        ::munmap(memory, mappedBytes);
+        return page_allocation::Allocation{};
+    }
+    if (prefault)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (::madvise(memory, mappedBytes, MADV_POPULATE_WRITE) != 0)
+        {
+            touchPages(memory, mappedBytes);
+        }
+#else
+        touchPages(memory, mappedBytes);
+#endif
+    }
+    return page_allocation::Allocation{memory, mappedBytes, PagePolicy::TransparentHugePages};
+}
+} // namespace
+
+namespace page_allocation
+{
+Allocation allocate(size_t bytes, PagePolicy policy, bool prefault)
+{
+    if (bytes >= HugePageSize)
+    {
+        Allocation allocation;
+        if (policy == PagePolicy::ExplicitHugePages)
+        {
+            allocation = allocateExplicitHugePages(bytes, prefault);
+        }
+        if (allocation.memory == nullptr && policy != PagePolicy::Default)
+        {
+            allocation = allocateTransparentHugePages(bytes, prefault);
+        }
+        if (allocation.memory != nullptr)
+        {
+            return allocation;
+        }
+    }
+
+    const size_t mappedBytes = roundUp(bytes, static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+    void *memory = mapAnonymous(mappedBytes, prefault ? MAP_POPULATE : 0);
+    return memory == nullptr ? Allocation{} : Allocation{memory, mappedBytes, PagePolicy::Default};
+}
+
+void release(void *memory, size_t mappedBytes)
+{
+    if (memory != nullptr)
+    {
+        ::munmap(memory, mappedBytes);
+    }
+}
+} // namespace page_allocation
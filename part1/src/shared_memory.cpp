@@ -0,0 +1,84 @@
+#include "shared_memory.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SharedMemorySegment::SharedMemorySegment(const std::string &name, size_t size)
+{
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return;
+    }
+    create(fd, size);
+    // The mapping stays valid after closing the file descriptor
+    ::close(fd);
+}
+
+SharedMemorySegment::SharedMemorySegment(const std::string &name, SegmentAccess access)
+{
+    const int fd = ::shm_open(name.c_str(), access == SegmentAccess::ReadWrite ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+    map(fd, access);
+    ::close(fd);
+}
+
+SharedMemorySegment::SharedMemorySegment(int fd, size_t size)
+{
+    create(fd, size);
+}
+
+SharedMemorySegment::SharedMemorySegment(int fd, SegmentAccess access)
+{
+    map(fd, access);
+}
+
+SharedMemorySegment::~SharedMemorySegment()
+{
+    if (data != nullptr)
+    {
+        ::munmap(data, length);
+    }
+}
+
+bool SharedMemorySegment::remove(const std::string &name)
+{
+    return ::shm_unlink(name.c_str()) == 0;
+}
+
+void SharedMemorySegment::create(int fd, size_t size)
+{
+    // Truncating to 0 first drops any old contents, so the whole segment reads as zero
+    if (size == 0 || ::ftruncate(fd, 0) != 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        return;
+    }
+    map(fd, SegmentAccess::ReadWrite);
+}
+
+void SharedMemorySegment::map(int fd, SegmentAccess access)
+{
+    struct stat fileStat
+    {
+    };
+    if (::fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        return;
+    }
+
+    const auto size = static_cast<size_t>(fileStat.st_size);
+    const int protection = access == SegmentAccess::ReadWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *mapped = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return;
+    }
+    data = static_cast<char *>(mapped);
+    length = size;
+    writable = access == SegmentAccess::ReadWrite;
+}
@@ -0,0 +1,318 @@
+#ifndef DIGIT_PARSING_H
+#define DIGIT_PARSING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#ifdef __SSE4_1__
+#include <immintrin.h>
+#endif
+
+// Decoding of decimal digits shared by the JSON parsers.
+//
+// How the digit kernel works (SWAR, SIMD within a register):
+// 1. 8 characters are loaded into one 64-bit integer. They are all digits if every byte is between 0x30 and
+// 0x39, which is checked for the 8 bytes at once with two masks and an addition.
+//
+// 2. Subtracting 0x30 from every byte gives the digit values. Adjacent bytes are combined with one
+// multiplication into 4 two digit numbers in 16-bit lanes, then into 2 four digit numbers in 32-bit lanes and
+// then into the eight digit number, 3 multiplications instead of 8 multiply-adds.
+//
+// 3. Integers take 16 digits per step with SSE: the 16 digit values are combined pairwise by multiply-adds
+// (_mm_maddubs_epi16, _mm_madd_epi16) into 8, 4 and then 2 eight digit numbers. The end of the digits is found
+// 8 characters at a time with the same masks.
+//
+// Shorter runs are right aligned in a buffer of '0' characters, so every run of up to 8 (16) digits is one step.
+namespace digit_parsing
+{
+constexpr uint64_t PowersOfTen[] = {1ULL,
+                                    10ULL,
+                                    100ULL,
+                                    1000ULL,
+                                    10000ULL,
+                                    100000ULL,
+                                    1000000ULL,
+                                    10000000ULL,
+                                    100000000ULL,
+                                    1000000000ULL,
+                                    10000000000ULL,
+                                    100000000000ULL,
+                                    1000000000000ULL,
+                                    10000000000000ULL,
+                                    100000000000000ULL,
+                                    1000000000000000ULL,
+                                    10000000000000000ULL,
+                                    100000000000000000ULL,
+                                    1000000000000000000ULL};
+// Most decimals of a fixed point value, 10^18 is the largest power of ten in an int64_t
+constexpr uint32_t MaxDecimals = 18;
+
+// Whether the 8 bytes of chunk are all the characters '0' to '9'
+inline bool isEightDigits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+// Value of 8 digit characters loaded in memory order, the first character is the most significant digit
+inline uint32_t parseEightDigits(uint64_t chunk)
+{
+    chunk -= 0x3030303030303030ULL;
+    // Two digit numbers in every 16-bit lane
+    chunk = (chunk * 10) + (chunk >> 8);
+    // Four digit numbers combined into the eight digit number in the upper 32 bits
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >>
+            32;
+    return static_cast<uint32_t>(chunk);
+}
+
+// Decode a run of up to 8 digits, false if a character is not a digit
+inline bool parseDigitRun(const char *digits, size_t length, uint64_t &value)
+{
+    char buffer[8] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+    std::memcpy(buffer + (8 - length), digits, length);
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, buffer, sizeof(chunk));
+    if (!isEightDigits(chunk))
+    {
+        return false;
+    }
+    value = parseEightDigits(chunk);
+    return true;
+}
+
+enum class DecimalStatus
+{
+    Ok,
+    // The text is not an optional '-', digits and an optional '.' followed by digits
+    Invalid,
+    // The scaled value does not fit in an int64_t
+    Overflow,
+    // The text has more decimals than requested and some of the dropped ones are not zero, the value is
+    // truncated towards zero
+    PrecisionLoss,
+};
+
+// Decode an unsigned decimal number 8 digits at a time. Invalid if a character is not a digit, Overflow if the
+// value does not fit in 64 bits.
+inline DecimalStatus parseDigits(std::string_view digits, uint64_t &value)
+{
+    value = 0;
+    size_t position = 0;
+    // The first run takes the remainder so every following run has exactly 8 digits
+    size_t runLength = digits.size() % 8 == 0 ? 8 : digits.size() % 8;
+    while (position < digits.size())
+    {
+        uint64_t run = 0;
+        if (!parseDigitRun(digits.data() + position, runLength, run))
+        {
+            return DecimalStatus::Invalid;
+        }
+        if (__builtin_mul_overflow(value, PowersOfTen[runLength], &value) ||
+            __builtin_add_overflow(value, run, &value))
+        {
+            // Keep checking that the rest are digits
+            DecimalStatus restStatus = DecimalStatus::Overflow;
+            for (const char c : digits.substr(position + runLength))
+            {
+                restStatus = c < '0' || c > '9' ? DecimalStatus::Invalid : restStatus;
+            }
+            return restStatus;
+        }
+        position += runLength;
+        runLength = 8;
+    }
+    return DecimalStatus::Ok;
+}
+
+// Number of digit characters from begin up to the first character that is not a digit or end
+inline size_t countDigits(const char *begin, const char *end)
+{
+    const char *position = begin;
+    while (end - position >= 8)
+    {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, position, sizeof(chunk));
+        // High bit of every byte below '0' or above '9'. A borrow or carry only leaves a byte that is not a digit
+        // and only changes the bytes after it, so the first one is exact.
+        const uint64_t notDigits =
+            ((chunk - 0x3030303030303030ULL) | (chunk + 0x4646464646464646ULL)) & 0x8080808080808080ULL;
+        if (notDigits != 0)
+        {
+            return static_cast<size_t>(position - begin) + (__builtin_ctzll(notDigits) / 8);
+        }
+        position += 8;
+    }
+    while (position < end && *position >= '0' && *position <= '9')
+    {
+        ++position;
+    }
+    return static_cast<size_t>(position - begin);
+}
+
+#ifdef __SSE4_1__
+// Value of 16 digit values (characters minus '0') in the bytes of chunk, the first byte is the most significant
+inline uint64_t combineSixteenDigits(__m128i chunk)
+{
+    // Two digit numbers in 8 16-bit lanes
+    chunk = _mm_maddubs_epi16(chunk, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    // Four digit numbers in 4 32-bit lanes, packed back into 16-bit lanes
+    chunk = _mm_madd_epi16(chunk, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    chunk = _mm_packus_epi32(chunk, chunk);
+    // Eight digit numbers in the 2 lower 32-bit lanes
+    chunk = _mm_madd_epi16(chunk, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    const uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(chunk));
+    const uint64_t low = static_cast<uint32_t>(_mm_extract_epi32(chunk, 1));
+    return (high * PowersOfTen[8]) + low;
+}
+
+// Shuffle masks that move the first n bytes to the end of a register and zero the rest, the mask for n starts at
+// byte n
+alignas(32) constexpr uint8_t RightAlignMasks[32] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                                     0x80, 0x80, 0x80, 0x80, 0x80, 0,    1,    2,    3,    4,    5,
+                                                     6,    7,    8,    9,    10,   11,   12,   13,   14,   15};
+#endif
+
+// Value of 16 digit characters, the first character is the most significant digit
+inline uint64_t parseSixteenDigits(const char *digits)
+{
+#ifdef __SSE4_1__
+    return combineSixteenDigits(
+        _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)), _mm_set1_epi8('0')));
+#else
+    uint64_t high = 0;
+    uint64_t low = 0;
+    std::memcpy(&high, digits, sizeof(high));
+    std::memcpy(&low, digits + 8, sizeof(low));
+    return (parseEightDigits(high) * PowersOfTen[8]) + parseEightDigits(low);
+#endif
+}
+
+// Decode an integer with an optional '-' at the start of [begin, end) in place, up to 16 digits per step.
+// Returns the number of characters read, 0 if there are no digits. Like a digit by digit loop a value of more
+// than 19 digits wraps around. Passing the end of the whole buffer rather than of the number lets numbers of
+// up to 15 digits take the fast path, one 16 byte load that finds the end of the digits and decodes them.
+inline size_t parseInt64(const char *begin, const char *end, int64_t &value)
+{
+    value = 0;
+    const bool negative = begin != end && *begin == '-';
+    const char *digits = negative ? begin + 1 : begin;
+    const size_t signLength = negative ? 1 : 0;
+
+#ifdef __SSE4_1__
+    if (end - digits >= 16)
+    {
+        const __m128i chunk =
+            _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)), _mm_set1_epi8('0'));
+        // A byte is a digit if its value minus '0' is at most 9 unsigned
+        const uint32_t digitMask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, _mm_set1_epi8(9)), _mm_set1_epi8(9))));
+        const auto digitCount = static_cast<uint32_t>(__builtin_ctz(~digitMask));
+        if (digitCount == 0)
+        {
+            return 0;
+        }
+        if (digitCount < 16)
+        {
+            const __m128i shuffleMask =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(RightAlignMasks + digitCount));
+            const uint64_t magnitude = combineSixteenDigits(_mm_shuffle_epi8(chunk, shuffleMask));
+            value = static_cast<int64_t>(negative ? 0 - magnitude : magnitude);
+            return signLength + digitCount;
+        }
+    }
+#endif
+
+    const size_t digitCount = countDigits(digits, end);
+    if (digitCount == 0)
+    {
+        return 0;
+    }
+
+    // The first step takes the remainder so every following step has exactly 16 digits
+    const size_t headLength = ((digitCount - 1) % 16) + 1;
+    char buffer[16] = {'0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0'};
+    std::memcpy(buffer + (16 - headLength), digits, headLength);
+    uint64_t magnitude = parseSixteenDigits(buffer);
+    for (size_t position = headLength; position < digitCount; position += 16)
+    {
+        magnitude = (magnitude * PowersOfTen[16]) + parseSixteenDigits(digits + position);
+    }
+
+    value = static_cast<int64_t>(negative ? 0 - magnitude : magnitude);
+    return signLength + digitCount;
+}
+
+// Decode a decimal number such as "0.01633102" into the integer value * 10^decimals, 1633102 for 8 decimals,
+// without going through floating point
+inline DecimalStatus parseFixedPoint(std::string_view text, uint32_t decimals, int64_t &value)
+{
+    value = 0;
+    if (decimals > MaxDecimals)
+    {
+        return DecimalStatus::Overflow;
+    }
+    const bool negative = !text.empty() && text[0] == '-';
+    if (negative)
+    {
+        text.remove_prefix(1);
+    }
+    const size_t point = text.find('.');
+    const std::string_view integerDigits = text.substr(0, point);
+    std::string_view fractionDigits = point == std::string_view::npos ? std::string_view() : text.substr(point + 1);
+    if (integerDigits.empty() && fractionDigits.empty())
+    {
+        return DecimalStatus::Invalid;
+    }
+
+    DecimalStatus status = DecimalStatus::Ok;
+    if (fractionDigits.size() > decimals)
+    {
+        const std::string_view dropped = fractionDigits.substr(decimals);
+        uint64_t droppedValue = 0;
+        // Only the digits are checked here, the value can be longer than 64 bits
+        for (const char c : dropped)
+        {
+            if (c < '0' || c > '9')
+            {
+                return DecimalStatus::Invalid;
+            }
+            droppedValue |= static_cast<uint64_t>(c - '0');
+        }
+        if (droppedValue != 0)
+        {
+            status = DecimalStatus::PrecisionLoss;
+        }
+        fractionDigits = fractionDigits.substr(0, decimals);
+    }
+
+    uint64_t integerPart = 0;
+    uint64_t fractionPart = 0;
+    const DecimalStatus integerStatus = parseDigits(integerDigits, integerPart);
+    if (integerStatus != DecimalStatus::Ok)
+    {
+        return integerStatus;
+    }
+    // At most 18 decimals, they always fit
+    if (parseDigits(fractionDigits, fractionPart) != DecimalStatus::Ok)
+    {
+        return DecimalStatus::Invalid;
+    }
+    // Fewer decimals than requested are scaled up
+    fractionPart *= PowersOfTen[decimals - fractionDigits.size()];
+
+    uint64_t scaled = 0;
+    if (__builtin_mul_overflow(integerPart, PowersOfTen[decimals], &scaled) ||
+        __builtin_add_overflow(scaled, fractionPart, &scaled) || scaled > static_cast<uint64_t>(INT64_MAX))
+    {
+        return DecimalStatus::Overflow;
+    }
+    value = negative ? -static_cast<int64_t>(scaled) : static_cast<int64_t>(scaled);
+    return status;
+}
+} // namespace digit_parsing
+
+#endif // DIGIT_PARSING_H
@@ -22,6 +22,9 @@ public:
 
     std::vector<Record> parseRecords(const std::string &json);
 
+    // Parse records with the price and quantity decoded to fixed point with the decimals of format
+    std::vector<FixedPointRecord> parseRecords(const std::string &json, const FixedPointFormat &format);
+
 private:
     // Skip whitespace characters
     void skipWhitespace(const std::string &s, uint32_t &index) const;
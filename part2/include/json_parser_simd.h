@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <immintrin.h>
@@ -34,12 +35,18 @@
 //
 // 3. Fianly ee perfom this process sequentially for all records in the JSON string and then iteratively for
 // all the JSON objcets in the array.
+//
+// 4. Values are read in place from the JSON string. The RecordView overload of parseRecords stores the price and
+// quantity as views into the JSON string and reuses the output vector, so once the vectors have grown to the
+// record count parsing does no heap allocation at all. The Record overload copies the two strings of every
+// record out of the views.
 class JsonParserSIMD
 {
 public:
     explicit JsonParserSIMD(uint32_t expectedRecordCount)
     {
         indexesOfQuotesOnJsonString.reserve(expectedRecordCount * jsonQuotes);
+        recordViews.reserve(expectedRecordCount);
     }
     ~JsonParserSIMD() = default;
     JsonParserSIMD(const JsonParserSIMD &other) = delete;
@@ -54,17 +61,28 @@ public:
     // JSON and the skipping pattern is known.
     std::vector<Record> parseRecords(const std::string &json);
 
+    // Parse records into records, replacing its contents. The price and quantity of every record view point
+    // into json, which must outlive them. Nothing is allocated once records and the quote indices have the
+    // capacity for the record count.
+    void parseRecords(std::string_view json, std::vector<RecordView> &records);
+
+    // Parse records with the price and quantity decoded to fixed point with the decimals of format, replacing
+    // the contents of records. Nothing is allocated once the vectors have the capacity for the record count.
+    void parseRecords(std::string_view json, const FixedPointFormat &format, std::vector<FixedPointRecord> &records);
+
 private:
     // Return indices of quotes using vectorized AVX2 registers and instructions.
-    void find_quotes_avx2(const std::string &s);
+    void find_quotes_avx2(std::string_view s);
 
     // Parse an integer value from string
-    int64_t parseInt64FromString(const std::string &s) const;
+    int64_t parseInt64FromString(std::string_view s) const;
 
     // Parse a boolean value from string t or f
-    bool parseBoolFromString(const std::string &s) const;
+    bool parseBoolFromString(std::string_view s) const;
 
     std::vector<uint32_t> indexesOfQuotesOnJsonString;
+    // Output of the RecordView overload reused by the Record and FixedPointRecord overloads
+    std::vector<RecordView> recordViews;
 };
 
 #endif // JSON_PARSER_SIMD_H
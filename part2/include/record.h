@@ -3,10 +3,13 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <immintrin.h>
 
+#include "digit_parsing.h"
+
 // Binance aggregate trade record
 struct Record
 {
@@ -19,4 +22,53 @@ struct Record
     bool m;        // Was the buyer the maker?
 };
 
+// Binance aggregate trade record whose price and quantity are views into the parsed JSON buffer, so parsing
+// allocates nothing per record. The views are only valid while the buffer is alive and unchanged.
+struct RecordView
+{
+    int64_t a;          // Aggregate tradeId
+    std::string_view p; // Price
+    std::string_view q; // Quantity
+    int64_t f;          // First tradeId
+    int64_t l;          // Last tradeId
+    int64_t T;          // Timestamp
+    bool m;             // Was the buyer the maker?
+};
+
+// Number of decimals the price and quantity are decoded with into fixed point
+struct FixedPointFormat
+{
+    uint32_t priceDecimals = 8;
+    uint32_t quantityDecimals = 8;
+};
+
+// Binance aggregate trade record with the price and quantity decoded to fixed point, p is the price times
+// 10^priceDecimals and q the quantity times 10^quantityDecimals
+struct FixedPointRecord
+{
+    int64_t a; // Aggregate tradeId
+    int64_t p; // Price
+    int64_t q; // Quantity
+    int64_t f; // First tradeId
+    int64_t l; // Last tradeId
+    int64_t T; // Timestamp
+    bool m;    // Was the buyer the maker?
+    // Ok, or the first failure of decoding p or q
+    digit_parsing::DecimalStatus status;
+};
+
+// Decode the price and quantity of a Record or RecordView
+template<typename SourceRecord>
+FixedPointRecord toFixedPointRecord(const SourceRecord &record, const FixedPointFormat &format)
+{
+    FixedPointRecord fixedPointRecord{record.a, 0, 0, record.f, record.l, record.T, record.m,
+                                      digit_parsing::DecimalStatus::Ok};
+    const digit_parsing::DecimalStatus priceStatus =
+        digit_parsing::parseFixedPoint(record.p, format.priceDecimals, fixedPointRecord.p);
+    const digit_parsing::DecimalStatus quantityStatus =
+        digit_parsing::parseFixedPoint(record.q, format.quantityDecimals, fixedPointRecord.q);
+    fixedPointRecord.status = priceStatus != digit_parsing::DecimalStatus::Ok ? priceStatus : quantityStatus;
+    return fixedPointRecord;
+}
+
 #endif // RECORD_H
@@ -47,6 +47,16 @@ std::vector<Record> JsonParser::parseRecords(const std::string &json)
     return records;
 }
 
+std::vector<FixedPointRecord> JsonParser::parseRecords(const std::string &json, const FixedPointFormat &format)
+{
+    std::vector<FixedPointRecord> fixedPointRecords;
+    for (const Record &record : parseRecords(json))
+    {
+        fixedPointRecords.push_back(toFixedPointRecord(record, format));
+    }
+    return fixedPointRecords;
+}
+
 // Skip whitespace characters
 void JsonParser::skipWhitespace(const std::string &s, uint32_t &index) const
 {
@@ -103,26 +113,10 @@ int64_t JsonParser::parseInt64(const std::string &s, uint32_t &index) const
         return 0;
     }
 
-    bool negative = false;
-    if (s[index] == '-')
-    {
-        negative = true;
-        ++index;
-    }
-
-    if (index >= s.size() || std::isdigit(static_cast<unsigned char>(s[index])) == 0)
-    {
-        return 0;
-    }
-
+    // Decoded in place from the string, up to 16 digits per step
     int64_t value = 0;
-    while (index < s.size() && std::isdigit(static_cast<unsigned char>(s[index])) != 0)
-    {
-        value = value * 10 + (s[index] - '0');
-        ++index;
-    }
-
-    return negative ? -value : value;
+    index += digit_parsing::parseInt64(s.data() + index, s.data() + s.size(), value);
+    return value;
 }
 
 // Parse a boolean value t or f
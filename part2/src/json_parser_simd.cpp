@@ -1,159 +1,81 @@
 #include "json_parser_simd.h"
 
+#include <algorithm>
+
 std::vector<Record> JsonParserSIMD::parseRecords(const std::string &json)
 {
+    parseRecords(json, recordViews);
+
     std::vector<Record> records;
+    records.reserve(recordViews.size());
+    for (const RecordView &view : recordViews)
+    {
+        records.push_back(Record{view.a, std::string(view.p), std::string(view.q), view.f, view.l, view.T, view.m});
+    }
+    return records;
+}
 
+void JsonParserSIMD::parseRecords(std::string_view json, std::vector<RecordView> &records)
+{
+    records.clear();
     indexesOfQuotesOnJsonString.clear();
 
     // Find in parallel of 32 byte chunks all quotes in the JSON string
     find_quotes_avx2(json);
 
-    // There are 18 quote characters in the json example above
-    // to help us verify correctness
-    // We can separate the quotes of the keys from the quotes of string values.
-    // We know that the first key has 2 quotes, then each key has 2 quotes
-    // However the p and q keys have string values which add 2 extra quotes each
-    // So the pattern of quotes for keys only is:
-    // 0: "a" -> 2 quotes
-    // 1: "p" -> 4 quotes (2 for key, 2 for string value)
-    // 2: "q" -> 4 quotes (2 for key, 2 for string value)
-    // 3: "f" -> 2 quotes
-    // 4: "l" -> 2 quotes
-    // 5: "T" -> 2 quotes
-    // 6: "m" -> 2 quotes
-    // Total: 18 quotes
-
-    // Number of keys
-    const uint32_t correctOrderKeysSize = 7;
-
-    // Process everything sequentially
-    uint32_t jsonQuoteCount = 0;
-    uint32_t correctOffsetForJsonKeys = 2; // Start with 2 then change to 4 for p and q later
-    uint32_t expectedKeyIndex = 0;
-    uint32_t indexOnJsonString = 0;
-
-    Record record{};
-    bool recordStarted = false;
-
-    for (uint32_t i = 0; i < indexesOfQuotesOnJsonString.size();)
+    // There are 18 quote characters in every record, a quote is at the same position of the pattern in every
+    // record so the quotes of a record are read by their position:
+    // 0, 1: "a" key, the number starts 4 characters after quote 0 and ends at the comma before quote 2
+    // 2, 3: "p" key
+    // 4, 5: p string value
+    // 6, 7: "q" key
+    // 8, 9: q string value
+    // 10, 11: "f" key, number until quote 12
+    // 12, 13: "l" key, number until quote 14
+    // 14, 15: "T" key, number until quote 16
+    // 16, 17: "m" key, the boolean starts 4 characters after quote 16
+    // Quotes of an incomplete record at the end are ignored
+    const uint32_t recordCount = static_cast<uint32_t>(indexesOfQuotesOnJsonString.size() / jsonQuotes);
+
+    // Number value from 4 characters after the key quote, decoded until the comma before the next key. The view
+    // runs to the end of json so the decoder can load 16 bytes at once past a short number.
+    const auto numberValue = [json](uint32_t keyQuote) { return json.substr(keyQuote + 4); };
+    // String value between its quotes
+    const auto stringValue = [json](uint32_t openingQuote, uint32_t closingQuote) {
+        return json.substr(openingQuote + 1, closingQuote - openingQuote - 1);
+    };
+
+    for (uint32_t recordIndex = 0; recordIndex < recordCount; ++recordIndex)
     {
-        jsonQuoteCount = i % jsonQuotes;
-        expectedKeyIndex = expectedKeyIndex % correctOrderKeysSize;
-        indexOnJsonString = indexesOfQuotesOnJsonString[i]; // get current quote index
-
-        if (jsonQuoteCount >= 2 && jsonQuoteCount <= 6)
-        {
-            // p and q keys have string values adding 2 extra quotes
-            correctOffsetForJsonKeys = 4;
-        }
-        else
-        {
-            correctOffsetForJsonKeys = 2;
-        }
-
-        // Get the values of every key
-        if (expectedKeyIndex == 0)
-        {
-            if (recordStarted)
-            {
-                records.push_back(record);
-            }
-            record = Record{};
-            recordStarted = true;
-            // process "a" key
-            // a value starts at current indexOnJsonString + 4
-            // a value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string a_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.a = parseInt64FromString(a_value);
-        }
-        else if (expectedKeyIndex == 1)
-        {
-            // process "p" key
-            // p value starts at current indexOnJsonString + 4
-            // p value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string p_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.p = p_value;
-        }
-        else if (expectedKeyIndex == 2)
-        {
-            // process "q" key
-            // q value starts at current indexOnJsonString + 4
-            // q value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string q_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.q = q_value;
-        }
-        else if (expectedKeyIndex == 3)
-        {
-            // process "f" key
-            // f value starts at current indexOnJsonString + 4
-            // f value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string f_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.f = parseInt64FromString(f_value);
-        }
-        else if (expectedKeyIndex == 4)
-        {
-            // process "l" key
-            // l value starts at current indexOnJsonString + 4
-            // l value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string l_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.l = parseInt64FromString(l_value);
-        }
-        else if (expectedKeyIndex == 5)
-        {
-            // process "T" key
-            // T value starts at current indexOnJsonString + 4
-            // T value ends at the -1 before the next quote index
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            const uint32_t indexOnJsonStringEnd = indexesOfQuotesOnJsonString[i + correctOffsetForJsonKeys] -
-                                                  1;
-            std::string T_value = json.substr(indexOnJsonStringStart,
-                                              indexOnJsonStringEnd - indexOnJsonStringStart);
-            record.T = parseInt64FromString(T_value);
-        }
-        else if (expectedKeyIndex == 6)
-        {
-            // process "m" key
-            // m value starts at current indexOnJsonString + 4
-            // we do not care about the ending quote since boolean is t or f
-            const uint32_t indexOnJsonStringStart = indexOnJsonString + 4;
-            std::string m_value = json.substr(indexOnJsonStringStart, 1);
-            record.m = parseBoolFromString(m_value);
-        }
-
-        i = i + correctOffsetForJsonKeys;
-        ++expectedKeyIndex;
+        const uint32_t *quotes = indexesOfQuotesOnJsonString.data() + recordIndex * jsonQuotes;
+
+        RecordView record{};
+        record.a = parseInt64FromString(numberValue(quotes[0]));
+        record.p = stringValue(quotes[4], quotes[5]);
+        record.q = stringValue(quotes[8], quotes[9]);
+        record.f = parseInt64FromString(numberValue(quotes[10]));
+        record.l = parseInt64FromString(numberValue(quotes[12]));
+        record.T = parseInt64FromString(numberValue(quotes[14]));
+        // We do not care about the ending of the boolean since it is t or f
+        record.m = parseBoolFromString(json.substr(std::min<size_t>(quotes[16] + 4, json.size()), 1));
+        records.push_back(record);
     }
+}
+
+void JsonParserSIMD::parseRecords(std::string_view json,
+                                  const FixedPointFormat &format,
+                                  std::vector<FixedPointRecord> &records)
+{
+    parseRecords(json, recordViews);
 
-    if (recordStarted)
+    records.clear();
+    for (const RecordView &view : recordViews)
     {
-        records.push_back(record);
+        records.push_back(toFixedPointRecord(view, format));
     }
-
-    return records;
 }
 
-void JsonParserSIMD::find_quotes_avx2(const std::string &s)
+void JsonParserSIMD::find_quotes_avx2(std::string_view s)
 {
     const uint32_t n = s.size();
     uint32_t i = 0;
@@ -195,32 +117,14 @@ void JsonParserSIMD::find_quotes_avx2(const std::string &s)
     }
 }
 
-int64_t JsonParserSIMD::parseInt64FromString(const std::string &s) const
+int64_t JsonParserSIMD::parseInt64FromString(std::string_view s) const
 {
-    if (s.empty())
-    {
-        return 0;
-    }
-
-    uint32_t index = 0;
-    bool negative = false;
-    if (s[index] == '-')
-    {
-        negative = true;
-        ++index;
-    }
-
     int64_t value = 0;
-    while (index < s.size() && s[index] >= '0' && s[index] <= '9')
-    {
-        value = value * 10 + (s[index] - '0');
-        ++index;
-    }
-
-    return negative ? -value : value;
+    digit_parsing::parseInt64(s.data(), s.data() + s.size(), value);
+    return value;
 }
 
-bool JsonParserSIMD::parseBoolFromString(const std::string &s) const
+bool JsonParserSIMD::parseBoolFromString(std::string_view s) const
 {
     if (s.empty())
     {
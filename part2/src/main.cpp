@@ -1,6 +1,10 @@
 #include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <random>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <curl/curl.h>
 
@@ -44,8 +48,273 @@ std::string download_json(const std::string &url)
     return content;
 }
 
+// Two records of the Binance format, the second with negative ids and "m":false
+static const std::string TestJson =
+    R"([{"a":26129,"p":"0.01633102","q":"4.70443515","f":27781,"l":27782,"T":1498793709153,"m":true},)"
+    R"({"a":-5,"p":"1.5","q":"2","f":-1,"l":-2,"T":3,"m":false}])";
+
+// Parse TestJson with the classic parser and both outputs of the SIMD parser and compare them with the known
+// values, the views must point at the price and quantity bytes inside the JSON. Returns false on a mismatch.
+static bool test_record_parsers()
+{
+    bool passed = true;
+    const std::vector<Record> expected = {{26129, "0.01633102", "4.70443515", 27781, 27782, 1498793709153, true},
+                                          {-5, "1.5", "2", -1, -2, 3, false}};
+    const auto sameRecord = [](const auto &x, const Record &y) {
+        return x.a == y.a && x.p == y.p && x.q == y.q && x.f == y.f && x.l == y.l && x.T == y.T && x.m == y.m;
+    };
+
+    JsonParser parser;
+    const std::vector<Record> classicRecords = parser.parseRecords(TestJson);
+    JsonParserSIMD parserSIMD(2);
+    const std::vector<Record> simdRecords = parserSIMD.parseRecords(TestJson);
+    std::vector<RecordView> views;
+    parserSIMD.parseRecords(TestJson, views);
+    if (classicRecords.size() != expected.size() || simdRecords.size() != expected.size() ||
+        views.size() != expected.size())
+    {
+        std::cout << "Error in parsed record count" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        if (!sameRecord(classicRecords[i], expected[i]))
+        {
+            std::cout << "Error in classic parser record " << i << std::endl;
+            passed = false;
+        }
+        if (!sameRecord(simdRecords[i], expected[i]))
+        {
+            std::cout << "Error in SIMD parser record " << i << std::endl;
+            passed = false;
+        }
+        if (!sameRecord(views[i], expected[i]))
+        {
+            std::cout << "Error in SIMD parser record view " << i << std::endl;
+            passed = false;
+        }
+    }
+    // The views point into the JSON string, not into copies
+    if (views[0].p.data() != TestJson.data() + TestJson.find("0.01633102") ||
+        views[1].q.data() != TestJson.data() + TestJson.find(R"("2")") + 1)
+    {
+        std::cout << "Error in record view positions" << std::endl;
+        passed = false;
+    }
+    return passed;
+}
+
+// Decode prices and quantities to fixed point directly and through both parsers, including the values that
+// overflow or lose precision. Returns false on a mismatch.
+static bool test_fixed_point()
+{
+    using digit_parsing::DecimalStatus;
+    struct FixedPointCase
+    {
+        std::string_view text;
+        DecimalStatus status;
+        int64_t value;
+    };
+    const FixedPointCase cases[] = {
+        {"0.01633102", DecimalStatus::Ok, 1633102},
+        {"4.70443515", DecimalStatus::Ok, 470443515},
+        {"-1.5", DecimalStatus::Ok, -150000000},
+        {"0.000000010", DecimalStatus::Ok, 1},
+        {"0.000000001", DecimalStatus::PrecisionLoss, 0},
+        {"92233720368.54775807", DecimalStatus::Ok, INT64_MAX},
+        {"92233720368.54775808", DecimalStatus::Overflow, 0},
+        {"99999999999999999999", DecimalStatus::Overflow, 0},
+        {"1e5", DecimalStatus::Invalid, 0},
+        {"1.2.3", DecimalStatus::Invalid, 0},
+        {"", DecimalStatus::Invalid, 0},
+    };
+    bool passed = true;
+    for (const FixedPointCase &testCase : cases)
+    {
+        int64_t value = 0;
+        const DecimalStatus status = digit_parsing::parseFixedPoint(testCase.text, 8, value);
+        if (status != testCase.status || (status != DecimalStatus::Overflow && value != testCase.value))
+        {
+            std::cout << "Error in fixed point decoding of \"" << testCase.text << "\"" << std::endl;
+            passed = false;
+        }
+    }
+
+    // The status of a record is the one of its price, or of its quantity if the price decodes
+    const std::string fixedPointJson =
+        R"([{"a":1,"p":"0.01633102","q":"0.000000010","f":1,"l":1,"T":1,"m":true},)"
+        R"({"a":2,"p":"0.000000001","q":"1","f":2,"l":2,"T":2,"m":false},)"
+        R"({"a":3,"p":"1","q":"92233720368.54775808","f":3,"l":3,"T":3,"m":true}])";
+    const FixedPointFormat format;
+    JsonParser parser;
+    const std::vector<FixedPointRecord> classicRecords = parser.parseRecords(fixedPointJson, format);
+    JsonParserSIMD parserSIMD(3);
+    std::vector<FixedPointRecord> simdRecords;
+    parserSIMD.parseRecords(fixedPointJson, format, simdRecords);
+    const DecimalStatus expectedStatus[] = {DecimalStatus::Ok, DecimalStatus::PrecisionLoss,
+                                            DecimalStatus::Overflow};
+    if (classicRecords.size() != 3 || simdRecords.size() != 3 || classicRecords[0].p != 1633102 ||
+        classicRecords[0].q != 1)
+    {
+        std::cout << "Error in fixed point records" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < classicRecords.size(); ++i)
+    {
+        const FixedPointRecord &x = classicRecords[i];
+        const FixedPointRecord &y = simdRecords[i];
+        if (x.status != expectedStatus[i] || y.status != x.status || x.a != y.a || x.p != y.p || x.q != y.q ||
+            x.f != y.f || x.l != y.l || x.T != y.T || x.m != y.m)
+        {
+            std::cout << "Error in fixed point record " << i << " of the classic and SIMD parsers" << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// Digit by digit loop the parsers used before the SWAR decoder, kept as the baseline of the integer benchmark
+static int64_t parse_int64_scalar(std::string_view s)
+{
+    uint32_t index = 0;
+    bool negative = false;
+    if (index < s.size() && s[index] == '-')
+    {
+        negative = true;
+        ++index;
+    }
+
+    int64_t value = 0;
+    while (index < s.size() && s[index] >= '0' && s[index] <= '9')
+    {
+        value = value * 10 + (s[index] - '0');
+        ++index;
+    }
+    return negative ? -value : value;
+}
+
+// Decode integers at the edges of digit_parsing::parseInt64: around the 16 digit SSE step, negative, without
+// digits and with the end of the buffer closer than 16 bytes, which takes the scalar path. Every number is
+// decoded once followed by a comma and more bytes and once at the very end of its buffer. Returns false on a
+// mismatch.
+static bool test_integer_decoding()
+{
+    struct IntegerCase
+    {
+        std::string text;
+        int64_t value;
+    };
+    const IntegerCase cases[] = {
+        {"0", 0},
+        {"7", 7},
+        {"1498793709153", 1498793709153},
+        {"123456789012345", 123456789012345},
+        {"1234567890123456", 1234567890123456},
+        {"12345678901234567", 12345678901234567},
+        {"9223372036854775807", INT64_MAX},
+        {"-42", -42},
+        {"-123456789012345", -123456789012345},
+        {"-1234567890123456", -1234567890123456},
+        {"-9223372036854775808", INT64_MIN},
+        {"-", 0},
+        {"", 0},
+    };
+    bool passed = true;
+    for (const IntegerCase &testCase : cases)
+    {
+        // No digits means nothing is read
+        const size_t expectedLength = testCase.text == "-" ? 0 : testCase.text.size();
+        for (const std::string &buffer : {testCase.text + ",\"f\":27781,\"l\":27782}", testCase.text})
+        {
+            int64_t value = -1;
+            const size_t length = digit_parsing::parseInt64(buffer.data(), buffer.data() + buffer.size(), value);
+            if (length != expectedLength || value != testCase.value)
+            {
+                std::cout << "Error in integer decoding of \"" << buffer << "\"" << std::endl;
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+// Decode synthetic trade ids and 13 digit millisecond timestamps with the scalar loop and with
+// digit_parsing::parseInt64, needs no downloaded data. Returns false if the two disagree.
+static bool benchmark_integer_decoding()
+{
+    std::cout << "\n\n========== INTEGER DECODING BENCHMARK ==========\n"
+              << std::endl;
+
+    // Comma separated numbers in one buffer like in the JSON, half ids and half timestamps. Both decoders read
+    // from the start of a number to the end of the buffer and stop at the comma, as the parsers do.
+    const uint32_t numberCount = 100000;
+    const uint32_t passes = 100;
+    std::mt19937_64 generator(42);
+    std::string buffer;
+    std::vector<size_t> offsets;
+    for (uint32_t i = 0; i < numberCount; ++i)
+    {
+        const uint64_t number = (i % 2 == 0) ? 2000000000ULL + (generator() % 8000000000ULL)
+                                             : 1700000000000ULL + (generator() % 100000000000ULL);
+        offsets.push_back(buffer.size());
+        buffer += std::to_string(number);
+        buffer.push_back(',');
+    }
+    const std::string_view bufferView(buffer);
+
+    int64_t checksumScalar = 0;
+    auto startTimeScalar = std::chrono::high_resolution_clock::now();
+    for (uint32_t pass = 0; pass < passes; ++pass)
+    {
+        for (const size_t offset : offsets)
+        {
+            checksumScalar += parse_int64_scalar(bufferView.substr(offset));
+        }
+    }
+    auto endTimeScalar = std::chrono::high_resolution_clock::now();
+
+    int64_t checksumSWAR = 0;
+    auto startTimeSWAR = std::chrono::high_resolution_clock::now();
+    for (uint32_t pass = 0; pass < passes; ++pass)
+    {
+        for (const size_t offset : offsets)
+        {
+            int64_t value = 0;
+            digit_parsing::parseInt64(buffer.data() + offset, buffer.data() + buffer.size(), value);
+            checksumSWAR += value;
+        }
+    }
+    auto endTimeSWAR = std::chrono::high_resolution_clock::now();
+
+    const double totalNumbers = static_cast<double>(numberCount) * passes;
+    const double averageTimeScalar =
+        static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(endTimeScalar - startTimeScalar).count()) /
+        totalNumbers;
+    const double averageTimeSWAR =
+        static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(endTimeSWAR - startTimeSWAR).count()) /
+        totalNumbers;
+
+    std::cout << "Numbers decoded: " << static_cast<uint64_t>(totalNumbers) << std::endl;
+    std::cout << "Scalar loop:     " << averageTimeScalar << " ns/number" << std::endl;
+    std::cout << "SWAR/SSE:        " << averageTimeSWAR << " ns/number" << std::endl;
+    std::cout << "Speedup:         " << (averageTimeScalar / averageTimeSWAR) << "x faster" << std::endl;
+    if (checksumScalar != checksumSWAR)
+    {
+        std::cout << "Error: the decoders disagree" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main()
 {
+    // Checks on literal JSON, they run without downloaded data
+    bool testsPassed = test_record_parsers();
+    testsPassed = test_fixed_point() && testsPassed;
+    testsPassed = test_integer_decoding() && testsPassed;
+
     // Binance Futures endpoint
     const std::string symbol = "BTCUSDT";
     const std::string limit = "10";
@@ -150,6 +419,62 @@ int main()
     std::cout << "Average time per record: " << (averageTimePerRecordSIMD / 1000.0) << " microseconds"
               << std::endl;
 
+    // ===========================================================================
+    // =================== SIMD PARSER RECORD VIEW BENCHMARK =====================
+    // ===========================================================================
+    std::cout << "\n\n========== SIMD PARSER RECORD VIEW BENCHMARK ==========\n"
+              << std::endl;
+
+    // The output vector is reused, after the first iteration parsing allocates nothing
+    std::vector<RecordView> tradeViews;
+    auto startTimeViews = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        parserSIMD.parseRecords(jsonData, tradeViews);
+    }
+    auto endTimeViews = std::chrono::high_resolution_clock::now();
+    auto durationViews = std::chrono::duration_cast<std::chrono::nanoseconds>(endTimeViews - startTimeViews);
+
+    // Calculate time per record for the record views
+    const uint32_t totalRecordsViews = tradeViews.size() * iterations;
+    const double averageTimePerRecordViews = static_cast<double>(durationViews.count()) /
+                                             static_cast<double>(totalRecordsViews);
+
+    // Display timing information for the record views
+    std::cout << "=== SIMD PARSER RECORD VIEW Performance Metrics ===" << std::endl;
+    std::cout << "Total records parsed: " << totalRecordsViews << std::endl;
+    std::cout << "Total time: " << durationViews.count() << " nanoseconds" << std::endl;
+    std::cout << "Average time per record: " << averageTimePerRecordViews << " nanoseconds" << std::endl;
+
+    // ===========================================================================
+    // =================== SIMD PARSER FIXED POINT BENCHMARK =====================
+    // ===========================================================================
+    std::cout << "\n\n========== SIMD PARSER FIXED POINT BENCHMARK ==========\n"
+              << std::endl;
+
+    // Prices and quantities decoded to integers with 8 decimals
+    const FixedPointFormat fixedPointFormat;
+    std::vector<FixedPointRecord> tradesFixedPoint;
+    auto startTimeFixedPoint = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        parserSIMD.parseRecords(jsonData, fixedPointFormat, tradesFixedPoint);
+    }
+    auto endTimeFixedPoint = std::chrono::high_resolution_clock::now();
+    auto durationFixedPoint =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(endTimeFixedPoint - startTimeFixedPoint);
+
+    // Calculate time per record for the fixed point records
+    const uint32_t totalRecordsFixedPoint = tradesFixedPoint.size() * iterations;
+    const double averageTimePerRecordFixedPoint = static_cast<double>(durationFixedPoint.count()) /
+                                                  static_cast<double>(totalRecordsFixedPoint);
+
+    // Display timing information for the fixed point records
+    std::cout << "=== SIMD PARSER FIXED POINT Performance Metrics ===" << std::endl;
+    std::cout << "Total records parsed: " << totalRecordsFixedPoint << std::endl;
+    std::cout << "Total time: " << durationFixedPoint.count() << " nanoseconds" << std::endl;
+    std::cout << "Average time per record: " << averageTimePerRecordFixedPoint << " nanoseconds" << std::endl;
+
     // ==================== PERFORMANCE COMPARISON ====================
     std::cout << "\n\n========== PERFORMANCE COMPARISON ==========\n"
               << std::endl;
@@ -159,8 +484,12 @@ int main()
 
     std::cout << "Classic Parser: " << averageTimePerRecordClassic << " ns/record" << std::endl;
     std::cout << "SIMD Parser:    " << averageTimePerRecordSIMD << " ns/record" << std::endl;
+    std::cout << "SIMD Views:     " << averageTimePerRecordViews << " ns/record" << std::endl;
+    std::cout << "SIMD Fixed:     " << averageTimePerRecordFixedPoint << " ns/record" << std::endl;
     std::cout << "Speedup:        " << speedup << "x faster" << std::endl;
     std::cout << "Improvement:    " << percentImprovement << "%" << std::endl;
 
-    return 0;
+    testsPassed = benchmark_integer_decoding() && testsPassed;
+
+    return testsPassed ? 0 : 1;
 }